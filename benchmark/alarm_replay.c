@@ -0,0 +1,259 @@
+/* Alarm queue microbenchmark.
+ *
+ * Replays an alarm trace recorded by a core built with ALARM_TRACE=1 against
+ * the alarm code of vice/src, as built with or without ALARM_USE_HEAP, and
+ * reports the time per operation. Dispatches that pick a different alarm
+ * than the recording are counted, those due on the same clock are only a
+ * different order, any other is a bug.
+ *
+ * usage: alarm_replay_array|alarm_replay_heap [-n passes] <trace>
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alarm.h"
+#include "lib.h"
+#include "log.h"
+
+#ifdef ALARM_USE_HEAP
+#define VARIANT "heap"
+#else
+#define VARIANT "array"
+#endif
+
+#define TRACE_NAME_LEN 32
+
+/* Same layout as the records written by alarm.c */
+struct trace_record
+{
+   uint32_t op;
+   uint32_t context;
+   uint32_t alarm;
+   uint32_t clk;
+};
+
+struct trace_op
+{
+   struct trace_record record;
+   const char *name;
+};
+
+static struct trace_op *ops = NULL;
+static size_t ops_count = 0;
+static unsigned contexts_count = 0;
+static unsigned alarms_count = 0;
+
+static alarm_context_t **contexts = NULL;
+static alarm_t **alarms = NULL;
+
+static unsigned long order_mismatches = 0;
+static unsigned long clock_mismatches = 0;
+
+/* The few library functions alarm.c depends on */
+void *lib_malloc(size_t size)
+{
+   void *p = malloc(size);
+   if (!p)
+   {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+   }
+   return p;
+}
+
+void lib_free(const void *ptr)
+{
+   free((void*)ptr);
+}
+
+char *lib_stralloc(const char *str)
+{
+   char *p = lib_malloc(strlen(str) + 1);
+   strcpy(p, str);
+   return p;
+}
+
+int log_error(log_t log, const char *format, ...)
+{
+   (void)log;
+   fprintf(stderr, "%s\n", format);
+   return 0;
+}
+
+static double get_time(void)
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void alarm_callback(CLOCK offset, void *data)
+{
+   /* What the callback did is part of the trace */
+   (void)offset;
+   (void)data;
+}
+
+static int load_trace(const char *path)
+{
+   FILE *f = fopen(path, "rb");
+   size_t ops_max = 0;
+   struct trace_record record;
+
+   if (!f)
+   {
+      perror(path);
+      return -1;
+   }
+
+   while (fread(&record, sizeof(record), 1, f) == 1)
+   {
+      struct trace_op *op;
+
+      if (ops_count == ops_max)
+      {
+         ops_max = ops_max ? ops_max * 2 : 65536;
+         ops = realloc(ops, ops_max * sizeof(*ops));
+         if (!ops)
+         {
+            fclose(f);
+            return -1;
+         }
+      }
+      op = &ops[ops_count++];
+      op->record = record;
+      op->name = NULL;
+
+      if (record.op == ALARM_TRACE_CONTEXT || record.op == ALARM_TRACE_NEW)
+      {
+         char *name = lib_malloc(TRACE_NAME_LEN);
+         if (fread(name, TRACE_NAME_LEN, 1, f) != 1)
+         {
+            free(name);
+            break;
+         }
+         name[TRACE_NAME_LEN - 1] = '\0';
+         op->name = name;
+      }
+      if (record.op == ALARM_TRACE_CONTEXT && record.context >= contexts_count)
+         contexts_count = record.context + 1;
+      if (record.op == ALARM_TRACE_NEW && record.alarm >= alarms_count)
+         alarms_count = record.alarm + 1;
+   }
+
+   fclose(f);
+   return 0;
+}
+
+static void check_dispatch(const struct trace_record *record)
+{
+   alarm_context_t *context = contexts[record->context];
+   alarm_t *expected = alarms[record->alarm];
+   int idx = context->next_pending_alarm_idx;
+
+   if (context->num_pending_alarms == 0 || idx < 0)
+      clock_mismatches++;
+   else if (context->pending_alarms[idx].alarm != expected)
+   {
+      if (expected && expected->pending_idx >= 0
+            && context->pending_alarms[expected->pending_idx].clk == context->pending_alarms[idx].clk)
+         order_mismatches++;
+      else
+         clock_mismatches++;
+   }
+}
+
+static void replay(int check)
+{
+   size_t i;
+
+   memset(contexts, 0, contexts_count * sizeof(*contexts));
+   memset(alarms, 0, alarms_count * sizeof(*alarms));
+
+   for (i = 0; i < ops_count; i++)
+   {
+      const struct trace_record *record = &ops[i].record;
+
+      switch (record->op)
+      {
+         case ALARM_TRACE_CONTEXT:
+            contexts[record->context] = alarm_context_new(ops[i].name);
+            break;
+         case ALARM_TRACE_NEW:
+            alarms[record->alarm] = alarm_new(contexts[record->context], ops[i].name, alarm_callback, NULL);
+            break;
+         case ALARM_TRACE_DESTROY:
+            alarm_destroy(alarms[record->alarm]);
+            alarms[record->alarm] = NULL;
+            break;
+         case ALARM_TRACE_SET:
+            alarm_set(alarms[record->alarm], record->clk);
+            break;
+         case ALARM_TRACE_UNSET:
+            alarm_unset(alarms[record->alarm]);
+            break;
+         case ALARM_TRACE_DISPATCH:
+            if (check)
+               check_dispatch(record);
+            alarm_context_dispatch(contexts[record->context], record->clk);
+            break;
+         case ALARM_TRACE_WARP:
+            alarm_context_time_warp(contexts[record->context], record->clk, record->alarm ? 1 : -1);
+            break;
+      }
+   }
+
+   for (i = 0; i < contexts_count; i++)
+      if (contexts[i])
+         alarm_context_destroy(contexts[i]);
+}
+
+int main(int argc, char **argv)
+{
+   const char *path = NULL;
+   int passes = 10;
+   int i;
+   double start, elapsed;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-n") && i + 1 < argc)
+         passes = atoi(argv[++i]);
+      else
+         path = argv[i];
+   }
+   if (!path || passes < 1)
+   {
+      fprintf(stderr, "usage: %s [-n passes] <trace>\n", argv[0]);
+      return 1;
+   }
+
+   if (load_trace(path) < 0 || !ops_count)
+   {
+      fprintf(stderr, "%s: no trace records\n", path);
+      return 1;
+   }
+
+   contexts = calloc(contexts_count ? contexts_count : 1, sizeof(*contexts));
+   alarms = calloc(alarms_count ? alarms_count : 1, sizeof(*alarms));
+
+   /* First pass checks the dispatch order and warms up the caches */
+   replay(1);
+
+   start = get_time();
+   for (i = 0; i < passes; i++)
+      replay(0);
+   elapsed = get_time() - start;
+
+   printf("%-5s %lu ops x %d passes: %.3f s, %.2f ns/op, dispatch order %lu, clock %lu mismatches\n",
+         VARIANT, (unsigned long)ops_count, passes, elapsed,
+         elapsed * 1e9 / ((double)ops_count * passes),
+         order_mismatches, clock_mismatches);
+
+   return clock_mismatches ? 2 : 0;
+}
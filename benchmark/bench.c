@@ -0,0 +1,331 @@
+/* Headless benchmark runner for the VICE libretro cores.
+ *
+ * Loads a built core, starts the given content (or none) and runs a fixed
+ * number of frames as fast as possible, with the output thrown away. The
+ * core's own performance counters provide the emulated cycles and the
+ * split per subsystem.
+ *
+ * usage: bench <core> [-n frames] [-w warmup] [-d] [-o key=value]... [content]
+ */
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libretro.h"
+#include "retro_perf.h"
+
+#define MAX_OPTIONS 64
+#define SUBSYSTEMS  RETRO_PERF_COUNTERS
+
+static const char *options[MAX_OPTIONS][2];
+static int options_count = 0;
+static const struct retro_core_option_definition *option_defs = NULL;
+static int discard_av = 0;
+static char work_dir[256];
+
+static retro_time_t get_time_usec(void)
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (retro_time_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static retro_perf_tick_t get_perf_counter(void)
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (retro_perf_tick_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static uint64_t get_cpu_features(void) { return 0; }
+static void perf_log(void) { }
+static void perf_register(struct retro_perf_counter *counter) { counter->registered = true; }
+static void perf_start(struct retro_perf_counter *counter) { counter->start = get_perf_counter(); }
+static void perf_stop(struct retro_perf_counter *counter)
+{
+   counter->total += get_perf_counter() - counter->start;
+   counter->call_cnt++;
+}
+
+static void log_cb(enum retro_log_level level, const char *fmt, ...)
+{
+   va_list ap;
+
+   if (level < RETRO_LOG_ERROR)
+      return;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+static const char *option_value(const char *key)
+{
+   const struct retro_core_option_definition *def;
+   int i;
+
+   for (i = 0; i < options_count; i++)
+      if (!strcmp(options[i][0], key))
+         return options[i][1];
+   for (def = option_defs; def && def->key; def++)
+      if (!strcmp(def->key, key))
+         return def->default_value ? def->default_value : def->values[0].value;
+   return NULL;
+}
+
+static bool environment(unsigned cmd, void *data)
+{
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+         ((struct retro_log_callback*)data)->log = log_cb;
+         return true;
+      case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+      {
+         struct retro_perf_callback *perf = (struct retro_perf_callback*)data;
+         perf->get_time_usec    = get_time_usec;
+         perf->get_cpu_features = get_cpu_features;
+         perf->get_perf_counter = get_perf_counter;
+         perf->perf_register    = perf_register;
+         perf->perf_start       = perf_start;
+         perf->perf_stop        = perf_stop;
+         perf->perf_log         = perf_log;
+         return true;
+      }
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+         *(const char**)data = work_dir;
+         return true;
+      case RETRO_ENVIRONMENT_GET_CORE_OPTIONS_VERSION:
+         *(unsigned*)data = 1;
+         return true;
+      case RETRO_ENVIRONMENT_SET_CORE_OPTIONS:
+         option_defs = (const struct retro_core_option_definition*)data;
+         return true;
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+      {
+         struct retro_variable *var = (struct retro_variable*)data;
+         var->value = option_value(var->key);
+         return var->value != NULL;
+      }
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool*)data = false;
+         return true;
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+         return true;
+      case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+         if (data)
+            *(int*)data = discard_av ? 0 : 3;
+         return true;
+      default:
+         return false;
+   }
+}
+
+static void video_cb(const void *data, unsigned width, unsigned height, size_t pitch) { }
+static void audio_cb(int16_t left, int16_t right) { }
+static size_t audio_batch_cb(const int16_t *data, size_t frames) { return frames; }
+static void input_poll_cb(void) { }
+static int16_t input_state_cb(unsigned port, unsigned device, unsigned index, unsigned id) { return 0; }
+
+/* Frame number, usec, cycles and the ticks of each subsystem */
+static int parse_row(const char *line, unsigned long long *col)
+{
+   char *end = NULL;
+   int i;
+
+   for (i = 0; i < 3 + SUBSYSTEMS; i++, line = end + 1)
+   {
+      col[i] = strtoull(line, &end, 10);
+      if (end == line || (*end != ',' && i < 2 + SUBSYSTEMS))
+         return 0;
+   }
+   return *end == '\n' || *end == '\0';
+}
+
+/* Sum the columns of the per-frame profile the core wrote on unload, over
+ * the last 'frames' rows, the ones that were timed */
+static int read_profile(int frames, unsigned long long *cycles, unsigned long long *ticks)
+{
+   char path[512], line[1024];
+   unsigned long long col[3 + SUBSYSTEMS];
+   struct dirent *entry;
+   DIR *dir;
+   FILE *fp = NULL;
+   int rows = 0, row = 0;
+
+   if ((dir = opendir(work_dir)) == NULL)
+      return 0;
+   while (!fp && (entry = readdir(dir)) != NULL)
+   {
+      size_t len = strlen(entry->d_name);
+      if (len > 9 && !strcmp(entry->d_name + len - 9, "_perf.csv"))
+      {
+         snprintf(path, sizeof(path), "%s/%s", work_dir, entry->d_name);
+         fp = fopen(path, "r");
+      }
+   }
+   closedir(dir);
+   if (!fp)
+      return 0;
+
+   while (fgets(line, sizeof(line), fp))
+      rows += parse_row(line, col);
+   rewind(fp);
+
+   *cycles = 0;
+   memset(ticks, 0, SUBSYSTEMS * sizeof(*ticks));
+   while (fgets(line, sizeof(line), fp))
+   {
+      if (!parse_row(line, col) || row++ < rows - frames)
+         continue;
+      *cycles += col[2];
+      for (int i = 0; i < SUBSYSTEMS; i++)
+         ticks[i] += col[3 + i];
+   }
+   fclose(fp);
+   unlink(path);
+   return 1;
+}
+
+#define CORE_SYMBOL(name) \
+   if (!(name = dlsym(core, #name))) { fprintf(stderr, "missing %s\n", #name); return 1; }
+
+int main(int argc, char **argv)
+{
+   static const char *subsystems[SUBSYSTEMS] = { RETRO_PERF_COUNTER_NAMES };
+   void (*retro_set_environment)(retro_environment_t);
+   void (*retro_set_video_refresh)(retro_video_refresh_t);
+   void (*retro_set_audio_sample)(retro_audio_sample_t);
+   void (*retro_set_audio_sample_batch)(retro_audio_sample_batch_t);
+   void (*retro_set_input_poll)(retro_input_poll_t);
+   void (*retro_set_input_state)(retro_input_state_t);
+   void (*retro_init)(void);
+   void (*retro_deinit)(void);
+   void (*retro_get_system_av_info)(struct retro_system_av_info*);
+   bool (*retro_load_game)(const struct retro_game_info*);
+   void (*retro_unload_game)(void);
+   void (*retro_run)(void);
+   struct retro_system_av_info av_info;
+   struct retro_game_info game;
+   const char *content = NULL;
+   int frames = 3000, warmup = 0;
+   unsigned long long cycles, ticks[SUBSYSTEMS], ticks_total = 0;
+   retro_time_t start = 0, elapsed;
+   double seconds;
+   char path[512];
+   void *core;
+   int i;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "usage: %s <core> [-n frames] [-w warmup] [-d] [-o key=value]... [content]\n", argv[0]);
+      return 1;
+   }
+
+   for (i = 2; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-n") && i + 1 < argc)
+         frames = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+         warmup = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-d"))
+         discard_av = 1;
+      else if (!strcmp(argv[i], "-o") && i + 1 < argc && options_count < MAX_OPTIONS - 1)
+      {
+         char *value = strchr(argv[++i], '=');
+         if (!value)
+            continue;
+         *value = '\0';
+         options[options_count][0] = argv[i];
+         options[options_count][1] = value + 1;
+         options_count++;
+      }
+      else
+         content = argv[i];
+   }
+
+   /* The core writes its profile into the save directory */
+   options[options_count][0] = "vice_perf_counters";
+   options[options_count][1] = "csv";
+   options_count++;
+
+   snprintf(work_dir, sizeof(work_dir), "/tmp/vice-bench-XXXXXX");
+   if (!mkdtemp(work_dir))
+   {
+      perror("mkdtemp");
+      return 1;
+   }
+
+   if (!(core = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL)))
+   {
+      fprintf(stderr, "%s\n", dlerror());
+      return 1;
+   }
+   CORE_SYMBOL(retro_set_environment);
+   CORE_SYMBOL(retro_set_video_refresh);
+   CORE_SYMBOL(retro_set_audio_sample);
+   CORE_SYMBOL(retro_set_audio_sample_batch);
+   CORE_SYMBOL(retro_set_input_poll);
+   CORE_SYMBOL(retro_set_input_state);
+   CORE_SYMBOL(retro_init);
+   CORE_SYMBOL(retro_deinit);
+   CORE_SYMBOL(retro_get_system_av_info);
+   CORE_SYMBOL(retro_load_game);
+   CORE_SYMBOL(retro_unload_game);
+   CORE_SYMBOL(retro_run);
+
+   retro_set_environment(environment);
+   retro_init();
+   retro_set_video_refresh(video_cb);
+   retro_set_audio_sample(audio_cb);
+   retro_set_audio_sample_batch(audio_batch_cb);
+   retro_set_input_poll(input_poll_cb);
+   retro_set_input_state(input_state_cb);
+
+   memset(&game, 0, sizeof(game));
+   game.path = content;
+   if (!retro_load_game(content ? &game : NULL))
+   {
+      fprintf(stderr, "cannot load %s\n", content ? content : "core");
+      return 1;
+   }
+   retro_get_system_av_info(&av_info);
+
+   for (i = 0; i < warmup + frames; i++)
+   {
+      if (i == warmup)
+         start = get_time_usec();
+      retro_run();
+   }
+   elapsed = get_time_usec() - start;
+
+   retro_unload_game();
+   retro_deinit();
+
+   seconds = elapsed / 1000000.0;
+   printf("%-24s frames %d  time %.3fs  fps %.1f  speed %.0f%%",
+          content ? strrchr(content, '/') ? strrchr(content, '/') + 1 : content : "(none)",
+          frames, seconds, frames / seconds, 100.0 * frames / seconds / av_info.timing.fps);
+
+   if (read_profile(frames, &cycles, ticks))
+   {
+      printf("  cycles/s %.0f ", cycles / seconds);
+      for (i = 0; i < SUBSYSTEMS; i++)
+         ticks_total += ticks[i];
+      for (i = 0; i < SUBSYSTEMS && ticks_total; i++)
+         printf(" %s %.0f%%", subsystems[i], 100.0 * ticks[i] / ticks_total);
+   }
+   printf("\n");
+
+   /* The core creates its own directory in the system directory */
+   snprintf(path, sizeof(path), "%s/vice", work_dir);
+   rmdir(path);
+   rmdir(work_dir);
+   return 0;
+}
@@ -0,0 +1,278 @@
+/* Render kernel microbenchmark.
+ *
+ * Converts a frame of color indices with the 1x1, 1x2 and 2x2 RGB renderers
+ * and the 1x1 PAL and CRT emulation renderers of vice/src/video at 16 and 32
+ * bits per pixel, once with the plain C code and once with each set of SIMD
+ * kernels the CPU supports, and reports the time of the fastest frame. The
+ * kernel sets take turns frame by frame, so a busy machine slows them all
+ * alike. Every kernel's output is compared to the C renderer's. By default the frame uses 16
+ * colors like the VIC-II, -c sets how many (up to 256) to measure the
+ * fallback for larger palettes.
+ *
+ * usage: render_kernels [-n frames] [-c colors]
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "render1x1.h"
+#include "render1x1crt.h"
+#include "render1x1pal.h"
+#include "render1x2.h"
+#include "render2x2.h"
+#include "rendersimd.h"
+#include "video.h"
+
+#define SRC_WIDTH  384
+#define SRC_HEIGHT 272
+#define SRC_PITCH  (SRC_WIDTH + 16)
+
+static const int levels[] = {
+   RENDER_SIMD_NONE, RENDER_SIMD_SSSE3, RENDER_SIMD_AVX2, RENDER_SIMD_NEON
+};
+
+#define NUM_LEVELS (sizeof(levels) / sizeof(levels[0]))
+
+enum filter
+{
+   FILTER_NONE,
+   FILTER_PAL,
+   FILTER_CRT
+};
+
+struct renderer
+{
+   const char *name;
+   int depth;
+   unsigned int scale_x;
+   unsigned int scale_y;
+   enum filter filter;
+};
+
+static const struct renderer renderers[] = {
+   { "1x1", 16, 1, 1, FILTER_NONE },
+   { "1x1", 32, 1, 1, FILTER_NONE },
+   { "1x2", 16, 1, 2, FILTER_NONE },
+   { "1x2", 32, 1, 2, FILTER_NONE },
+   { "2x2", 16, 2, 2, FILTER_NONE },
+   { "2x2", 32, 2, 2, FILTER_NONE },
+   { "pal", 16, 1, 1, FILTER_PAL },
+   { "pal", 32, 1, 1, FILTER_PAL },
+   { "crt", 16, 1, 1, FILTER_CRT },
+   { "crt", 32, 1, 1, FILTER_CRT },
+};
+
+/* The PAL and CRT renderers' output tables, normally from video-color.c */
+uint32_t gamma_red[256 * 3];
+uint32_t gamma_grn[256 * 3];
+uint32_t gamma_blu[256 * 3];
+uint32_t alpha = 0;
+
+static video_render_config_t config;
+static uint8_t src[SRC_PITCH * SRC_HEIGHT];
+static uint8_t *reference;
+static uint8_t *target;
+
+static double get_time(void)
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Physical colors as video_render_setphysicalcolor() stores them */
+static void set_colors(int depth)
+{
+   int i;
+
+   srand(1);
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t color = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+
+      if (depth == 16)
+      {
+         color &= 0xffff;
+         color |= color << 16;
+      }
+      config.color_tables.physical_colors[i] = color;
+   }
+
+   /* Like video_calc_ycbcrtable() does with the default resources */
+   for (i = 0; i < 256; i++)
+   {
+      int32_t y = (rand() % 256) * 256;
+      int32_t cb = rand() % 200 - 100;
+      int32_t cr = rand() % 200 - 100;
+
+      config.color_tables.ytablel[i] = y * 32;
+      config.color_tables.ytableh[i] = y * 191;
+      config.color_tables.cbtable[i] = cb * 256;
+      config.color_tables.crtable[i] = cr * 256;
+      config.color_tables.cbtable_odd[i] = -cb * 256;
+      config.color_tables.crtable_odd[i] = -cr * 256;
+   }
+   for (i = 0; i < 256 * 3; i++)
+   {
+      uint32_t v = i < 256 ? 0 : i > 511 ? 255 : i - 256;
+
+      if (depth == 16)
+      {
+         gamma_red[i] = (v >> 3) << 11;
+         gamma_grn[i] = (v >> 2) << 5;
+         gamma_blu[i] = v >> 3;
+      }
+      else
+      {
+         gamma_red[i] = v << 16;
+         gamma_grn[i] = v << 8;
+         gamma_blu[i] = v;
+      }
+   }
+   config.video_resources.pal_oddlines_offset = 750;
+}
+
+static void render(const struct renderer *r, uint8_t *trg)
+{
+   unsigned int pitcht = SRC_WIDTH * r->scale_x * (r->depth / 8);
+   video_render_color_tables_t *colortab = &config.color_tables;
+
+   /* The filters look at 2 pixels left and right */
+   if (r->filter == FILTER_PAL)
+   {
+      if (r->depth == 16)
+         render_16_1x1_pal(colortab, src, trg, SRC_WIDTH - 4, SRC_HEIGHT - 1, 2, 1, 0, 0, SRC_PITCH, pitcht, &config);
+      else
+         render_32_1x1_pal(colortab, src, trg, SRC_WIDTH - 4, SRC_HEIGHT - 1, 2, 1, 0, 0, SRC_PITCH, pitcht, &config);
+   }
+   else if (r->filter == FILTER_CRT)
+   {
+      if (r->depth == 16)
+         render_16_1x1_crt(colortab, src, trg, SRC_WIDTH - 4, SRC_HEIGHT, 2, 0, 0, 0, SRC_PITCH, pitcht);
+      else
+         render_32_1x1_crt(colortab, src, trg, SRC_WIDTH - 4, SRC_HEIGHT, 2, 0, 0, 0, SRC_PITCH, pitcht);
+   }
+   else if (r->scale_x == 1 && r->scale_y == 1)
+   {
+      if (r->depth == 16)
+         render_16_1x1_04(colortab, src, trg, SRC_WIDTH, SRC_HEIGHT, 0, 0, 0, 0, SRC_PITCH, pitcht);
+      else
+         render_32_1x1_04(colortab, src, trg, SRC_WIDTH, SRC_HEIGHT, 0, 0, 0, 0, SRC_PITCH, pitcht);
+   }
+   else if (r->scale_x == 1)
+   {
+      if (r->depth == 16)
+         render_16_1x2_04(colortab, src, trg, SRC_WIDTH, SRC_HEIGHT * 2, 0, 0, 0, 0, SRC_PITCH, pitcht, 1, &config);
+      else
+         render_32_1x2_04(colortab, src, trg, SRC_WIDTH, SRC_HEIGHT * 2, 0, 0, 0, 0, SRC_PITCH, pitcht, 1, &config);
+   }
+   else
+   {
+      if (r->depth == 16)
+         render_16_2x2_04(colortab, src, trg, SRC_WIDTH * 2, SRC_HEIGHT * 2, 0, 0, 0, 0, SRC_PITCH, pitcht, 1, &config);
+      else
+         render_32_2x2_04(colortab, src, trg, SRC_WIDTH * 2, SRC_HEIGHT * 2, 0, 0, 0, 0, SRC_PITCH, pitcht, 1, &config);
+   }
+}
+
+int main(int argc, char **argv)
+{
+   size_t target_size = SRC_WIDTH * 2 * SRC_HEIGHT * 2 * 4;
+   int frames = 1000;
+   int colors = 16;
+   int mismatches = 0;
+   unsigned int i, j;
+
+   for (i = 1; i < (unsigned int)argc; i++)
+   {
+      if (!strcmp(argv[i], "-n") && i + 1 < (unsigned int)argc)
+         frames = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-c") && i + 1 < (unsigned int)argc)
+         colors = atoi(argv[++i]);
+      else
+      {
+         fprintf(stderr, "usage: %s [-n frames] [-c colors]\n", argv[0]);
+         return 1;
+      }
+   }
+   if (frames < 1 || colors < 1 || colors > 256)
+   {
+      fprintf(stderr, "usage: %s [-n frames] [-c colors]\n", argv[0]);
+      return 1;
+   }
+
+   for (i = 0; i < sizeof(src); i++)
+      src[i] = (uint8_t)(rand() % colors);
+
+   /* Every line is rendered, none copied from the line above */
+   config.readable = 0;
+   config.doublescan = 1;
+
+   reference = malloc(target_size);
+   target = malloc(target_size);
+
+   printf("%d colors, %dx%d pixels, %d frames, detected: %s\n",
+         colors, SRC_WIDTH, SRC_HEIGHT, frames, render_simd_name(render_simd_detect()));
+
+   for (i = 0; i < sizeof(renderers) / sizeof(renderers[0]); i++)
+   {
+      const struct renderer *r = &renderers[i];
+      double best[NUM_LEVELS];
+      int same[NUM_LEVELS];
+      int n;
+
+      set_colors(r->depth);
+      memset(reference, 0, target_size);
+      render_simd_select(RENDER_SIMD_NONE);
+      render(r, reference);
+
+      for (j = 0; j < NUM_LEVELS; j++)
+      {
+         best[j] = 0.0;
+         if (render_simd_select(levels[j]) < 0)
+            continue;
+
+         memset(target, 0, target_size);
+         render(r, target);
+         same[j] = !memcmp(target, reference, target_size);
+         if (!same[j])
+            mismatches++;
+      }
+
+      for (n = 0; n < frames; n++)
+      {
+         for (j = 0; j < NUM_LEVELS; j++)
+         {
+            double elapsed;
+
+            if (render_simd_select(levels[j]) < 0)
+               continue;
+
+            elapsed = get_time();
+            render(r, target);
+            elapsed = get_time() - elapsed;
+            if (best[j] == 0.0 || elapsed < best[j])
+               best[j] = elapsed;
+         }
+      }
+
+      for (j = 0; j < NUM_LEVELS; j++)
+      {
+         if (best[j] == 0.0)
+            continue;
+
+         printf("%s %2d bpp %-5s %8.2f us/frame %6.2fx%s\n",
+               r->name, r->depth, render_simd_name(levels[j]),
+               best[j] * 1e6, best[0] / best[j], same[j] ? "" : "  MISMATCH");
+      }
+   }
+
+   free(reference);
+   free(target);
+
+   return mismatches ? 2 : 0;
+}
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Build the cores and run the benchmark workloads on each of them.
+#
+# usage: benchmark/run.sh [-b] [-d] [-o dir] [-w dir] [target...]
+#
+#   -b      use the cores already built in the source tree instead of
+#           building them
+#   -d      tell the core that video and audio are not used, so it can
+#           skip rendering and resampling
+#   -o dir  directory the cores are built in (default: benchmark/build)
+#   -w dir  directory holding the workload images (default: benchmark/workloads)
+#
+# The objects of the targets clash, so each target is built in a copy of
+# the source tree under the build directory, leaving the developer's own
+# build alone. The copies are kept, later runs only rebuild what changed.
+#
+# Without targets all of them are benchmarked. Extra core options can be
+# passed with BENCH_OPTIONS, e.g. BENCH_OPTIONS="-o vice_drive_true_emulation=enabled"
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT_DIR=$(dirname "$BENCH_DIR")
+WORKLOAD_DIR="$BENCH_DIR/workloads"
+BUILD_DIR="$BENCH_DIR/build"
+BUILD=1
+BENCH_FLAGS=""
+
+while getopts "bdo:w:" opt; do
+   case $opt in
+      b) BUILD=0 ;;
+      d) BENCH_FLAGS="$BENCH_FLAGS -d" ;;
+      o) BUILD_DIR=$OPTARG ;;
+      w) WORKLOAD_DIR=$OPTARG ;;
+      *) exit 1 ;;
+   esac
+done
+shift $((OPTIND - 1))
+
+TARGETS=${*:-"x64 x64sc x64scpu x128 xvic xplus4 xpet xcbm2"}
+JOBS=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+
+make -C "$BENCH_DIR" -s || exit 1
+
+for target in $TARGETS; do
+   core="$ROOT_DIR/vice_${target}_libretro.so"
+
+   if [ $BUILD -eq 1 ]; then
+      echo "building $target"
+      src="$BUILD_DIR/$target"
+      mkdir -p "$src" || exit 1
+      # tar keeps the modification times, so make only sees changed files
+      (cd "$ROOT_DIR" && git ls-files -co --exclude-standard \
+         | grep -v -e '^benchmark/' -e '\.o$' -e '\.a$' -e '\.so$' -e '\.dll$' -e '\.dylib$' \
+         | while read -r f; do [ -f "$f" ] && echo "$f"; done | tar cf - -T -) \
+         | (cd "$src" && tar xf -) || exit 1
+      make -C "$src" -s -j"$JOBS" EMUTYPE=$target > /dev/null || exit 1
+      core="$src/vice_${target}_libretro.so"
+   fi
+   if [ ! -f "$core" ]; then
+      echo "$target: $core not found"
+      continue
+   fi
+
+   echo "== $target"
+   grep -v '^#' "$BENCH_DIR/workloads.txt" | while read -r targets frames content; do
+      [ -z "$targets" ] && continue
+      case ",$targets," in
+         *",$target,"*|",*,") ;;
+         *) continue ;;
+      esac
+      if [ "$content" = "-" ]; then
+         "$BENCH_DIR/bench" "$core" -n "$frames" $BENCH_FLAGS $BENCH_OPTIONS
+      elif [ -f "$WORKLOAD_DIR/$content" ]; then
+         "$BENCH_DIR/bench" "$core" -n "$frames" $BENCH_FLAGS $BENCH_OPTIONS "$WORKLOAD_DIR/$content"
+      fi
+   done
+done
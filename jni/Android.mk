@@ -7,6 +7,8 @@ INCFLAGS    :=
 
 EMUTYPE     ?= x64
 
+HAVE_THREADS := 1
+
 include $(CORE_DIR)/Makefile.common
 
 COREFLAGS := -DCORE_NAME=\"$(EMUTYPE)\" \
@@ -1,5 +1,7 @@
 #include "libretro.h"
 #include "libretro-core.h"
+#include "retro_rewind.h"
+#include "retro_perf.h"
 
 #include "archdep.h"
 #include "c64.h"
@@ -14,6 +16,8 @@
 #include "diskimage.h"
 #include "attach.h"
 #include "interrupt.h"
+#include "alarm.h"
+#include "maincpu.h"
 #include "datasette.h"
 #ifdef __PET__
 #include "keyboard.h"
@@ -22,6 +26,7 @@
 #endif
 #include "initcmdline.h"
 #include "vsync.h"
+#include "sound.h"
 #include "log.h"
 
 #ifndef MIN
@@ -31,6 +36,13 @@
 // Our virtual time counter, increased by retro_run()
 long microSecCounter = 0;
 int cpuloop = 1;
+int retro_av_enable = AV_ENABLE_VIDEO | AV_ENABLE_AUDIO;
+int retro_draw_frame = 1;
+// Render the whole canvas instead of the changed lines only
+int retro_render_full = 1;
+// Set when retro_bmp was updated during the frame
+int retro_frame_changed = 1;
+static bool retro_can_dupe = false;
 
 // VKBD 
 extern int SHOWKEY;
@@ -38,6 +50,9 @@ unsigned int opt_vkbd_theme;
 unsigned int opt_vkbd_alpha = 204;
 unsigned int vkbd_alpha = 204;
 
+// Rewind hotkey held
+extern unsigned int rewindmode;
+
 // Core vars
 extern char core_key_state[512];
 extern char core_old_key_state[512];
@@ -48,11 +63,13 @@ static char* autostartString = NULL;
 char RETRO_DIR[RETRO_PATH_MAX];
 static char* core_options_legacy_strings = NULL;
 
-static snapshot_stream_t* snapshot_stream = NULL;
-static int load_trap_happened = 0;
-static int save_trap_happened = 0;
+/* Savestate size is measured once and cached until the machine configuration
+   or the media change, see snapshot_size_invalidate() */
+static size_t snapshot_size_cached = 0;
+static void serialize_cache_invalidate(void);
+static void serialize_cache_free(void);
 
-int mapper_keys[36] = { 0 };
+int mapper_keys[37] = { 0 };
 unsigned int vice_devices[5];
 unsigned int opt_mapping_options_display;
 unsigned int opt_video_options_display;
@@ -86,6 +103,7 @@ unsigned short int retro_bmp[RETRO_BMP_SIZE];
 // Core options
 extern int RETROTDE;
 extern int RETRODSE;
+extern int RETRODRIVEIDLESKIP;
 extern int RETRORESET;
 extern int RETROSIDENGINE;
 extern int RETROSIDMODL;
@@ -143,6 +161,10 @@ unsigned int opt_jiffydos = 0;
 static unsigned int opt_jiffydos_prev = 0;
 #endif
 static unsigned int request_reload_restart = 0;
+static unsigned int request_update_sid = 0;
+static unsigned int request_update_frameskip = 0;
+static unsigned int opt_frameskip = 0;
+static unsigned int opt_frameskip_threshold = 33;
 static unsigned int sound_volume_counter = 3;
 unsigned int opt_audio_leak_volume = 0;
 unsigned int opt_statusbar = 0;
@@ -174,6 +196,7 @@ extern unsigned int turbo_pulse;
 #elif defined(__X128__)
 #include "c64model.h"
 #include "c128model.h"
+#include "vdc.h"
 #elif defined(__PET__)
 #include "petmodel.h"
 #elif defined(__CBM2__)
@@ -484,8 +507,16 @@ static int process_cmdline(const char* argv)
             argv = nib_output;
         }
 
+        // ZIP with a single disk or tape image, uncompress into memory
+        char zip_image[RETRO_PATH_MAX] = {0};
+        if (strendswith(argv, ".zip")
+         && zip_uncompress_memory(full_path, zip_path, browsed_file[0] != '\0' ? browsed_file : NULL, zip_image) == 0)
+        {
+            snprintf(full_path, sizeof(full_path), "%s", zip_image);
+            argv = full_path;
+        }
         // ZIP
-        if (strendswith(argv, ".zip"))
+        else if (strendswith(argv, ".zip"))
         {
             path_mkdir(zip_path);
             zip_uncompress(full_path, zip_path, NULL);
@@ -912,6 +943,7 @@ int pre_main()
     return 0;
 }
 
+static void option_cache_reset(void);
 static void update_variables(void);
 
 extern int ui_init_finalize(void);
@@ -930,6 +962,7 @@ void reload_restart()
     /* Update resources from environment just like on fresh start of core */
     sound_volume_counter = 3;
     retro_ui_finalized = 0;
+    option_cache_reset();
     update_variables();
     /* Some resources are not set until we call this */
     ui_init_finalize();
@@ -1079,6 +1112,19 @@ void retro_set_environment(retro_environment_t cb)
          },
          "VICII"
       },
+#ifdef HAVE_THREADS
+      {
+         "vice_vdc_parallel",
+         "Parallel VDC Rendering",
+         "Draws the VDC (80 cols) lines on their own thread while the emulation goes on.",
+         {
+            { "disabled", NULL },
+            { "enabled", NULL },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
+#endif
       {
          "vice_c128_go64",
          "GO64",
@@ -1221,6 +1267,57 @@ void retro_set_environment(retro_environment_t cb)
          },
          "enabled"
       },
+      {
+         "vice_drive_idle_skip",
+         "Drive Idle Loop Skip",
+         "Skips the idle loop of the 1541 and 1571 DOS while the drive waits for the computer. Lowers the CPU load of True Drive Emulation, interrupts may hit the drive a few cycles apart.",
+         {
+            { "disabled", NULL },
+            { "enabled", NULL },
+            { NULL, NULL },
+         },
+         "enabled"
+      },
+      {
+         "vice_rewind",
+         "Rewind",
+         "Length of the rewind history kept by the core, use the 'Hold Rewind' hotkey to step back.",
+         {
+            { "disabled", NULL },
+            { "10", "10 seconds" },
+            { "30", "30 seconds" },
+            { "60", "60 seconds" },
+            { "120", "120 seconds" },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
+      {
+         "vice_rewind_memory",
+         "Rewind Memory Limit",
+         "Memory for the rewind history. States are stored as differences, older ones are dropped when the limit is reached.",
+         {
+            { "16", "16MB" },
+            { "32", "32MB" },
+            { "64", "64MB" },
+            { "128", "128MB" },
+            { "256", "256MB" },
+            { NULL, NULL },
+         },
+         "64"
+      },
+      {
+         "vice_perf_counters",
+         "Performance Counters",
+         "Measure the time spent per frame in each subsystem, written to the save directory when the content is closed.",
+         {
+            { "disabled", NULL },
+            { "csv", "CSV" },
+            { "json", "JSON" },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
       {
          "vice_video_options_display",
          "Show Video Options",
@@ -1374,6 +1471,43 @@ void retro_set_environment(retro_environment_t cb)
          },
          "16bit"
       },
+      {
+         "vice_frameskip",
+         "Frameskip",
+         "Skip drawing frames to keep full speed on slow devices. Emulation and audio are not affected. 'Auto' skips when the frontend is about to run out of audio, 'Manual' when its audio buffer is below the threshold.",
+         {
+            { "disabled", NULL },
+            { "auto", "Auto" },
+            { "manual", "Manual" },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
+      {
+         "vice_frameskip_threshold",
+         "Frameskip Threshold (%)",
+         "Audio buffer occupancy below which frames are skipped when 'Frameskip' is 'Manual'.",
+         {
+            { "15", NULL },
+            { "18", NULL },
+            { "21", NULL },
+            { "24", NULL },
+            { "27", NULL },
+            { "30", NULL },
+            { "33", NULL },
+            { "36", NULL },
+            { "39", NULL },
+            { "42", NULL },
+            { "45", NULL },
+            { "48", NULL },
+            { "51", NULL },
+            { "54", NULL },
+            { "57", NULL },
+            { "60", NULL },
+            { NULL, NULL },
+         },
+         "33"
+      },
 #if defined(__VIC20__)
       {
          "vice_vic20_external_palette",
@@ -1848,6 +1982,19 @@ void retro_set_environment(retro_environment_t cb)
          },
          "1500"
       },
+#ifdef HAVE_THREADS
+      {
+         "vice_sid_parallel",
+         "Parallel SID Synthesis",
+         "Synthesizes each SID chip on its own thread when more than one is emulated. Only helps with extra SIDs enabled in 'vicerc'.",
+         {
+            { "disabled", NULL },
+            { "enabled", NULL },
+            { NULL, NULL },
+         },
+         "disabled"
+      },
+#endif
 #endif
 #if !defined(__PET__) && !defined(__CBM2__) && !defined(__VIC20__)
       {
@@ -2066,6 +2213,13 @@ void retro_set_environment(retro_environment_t cb)
          {{ NULL, NULL }},
          ""
       },
+      {
+         "vice_mapper_rewind",
+         "Hotkey: Hold Rewind",
+         "Hold the mapped key to rewind. Requires 'Rewind' to be enabled.",
+         {{ NULL, NULL }},
+         "---"
+      },
       /* Datasette controls */
       {
          "vice_mapper_datasette_toggle_hotkeys",
@@ -2328,6 +2482,7 @@ void retro_set_environment(retro_environment_t cb)
             || strstr(core_options[i].key, "vice_mapper_reset")
             || strstr(core_options[i].key, "vice_mapper_zoom_mode_toggle")
             || strstr(core_options[i].key, "vice_mapper_warp_mode")
+            || strstr(core_options[i].key, "vice_mapper_rewind")
             || strstr(core_options[i].key, "vice_mapper_datasette_toggle_hotkeys")
             || strstr(core_options[i].key, "vice_mapper_datasette_start")
             || strstr(core_options[i].key, "vice_mapper_datasette_stop")
@@ -2432,25 +2587,115 @@ void retro_set_environment(retro_environment_t cb)
 int log_resources_set_int(const char *name, int value)
 {
     log_cb(RETRO_LOG_INFO, "Resource %s = %d\n", name, value);
+    snapshot_size_invalidate();
     return resources_set_int(name, value);
 }
 
 int log_resources_set_string(const char *name, const char* value)
 {
     log_cb(RETRO_LOG_INFO, "Resource %s = \"%s\"\n", name, value);
+    snapshot_size_invalidate();
     return resources_set_string(name, value);
 }
 
+/* Core option values as last seen by update_variables(), which applies
+ * only the options whose value differs */
+#define OPTION_CACHE_MAX 128
+static struct
+{
+   const char *key;
+   char *value;
+} option_cache[OPTION_CACHE_MAX];
+static unsigned int option_cache_count = 0;
+
+static void option_cache_reset(void)
+{
+   unsigned int i;
+
+   for (i = 0; i < option_cache_count; i++)
+      free(option_cache[i].value);
+   option_cache_count = 0;
+}
+
+static int option_cache_find(const char *key)
+{
+   unsigned int i;
+
+   for (i = 0; i < option_cache_count; i++)
+      if (strcmp(option_cache[i].key, key) == 0)
+         return i;
+   return -1;
+}
+
+/* Makes the next update_variables() apply an option that depends on another one */
+static void option_invalidate(const char *key)
+{
+   int i = option_cache_find(key);
+
+   if (i >= 0)
+   {
+      free(option_cache[i].value);
+      option_cache[i].value = NULL;
+   }
+}
+
+/* Queries an option like RETRO_ENVIRONMENT_GET_VARIABLE, but only returns
+ * true if its value changed since the previous query. var->value is set
+ * either way. */
+static bool option_changed(struct retro_variable *var)
+{
+   int i;
+
+   var->value = NULL;
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, var) || !var->value)
+      return false;
+
+   i = option_cache_find(var->key);
+   if (i >= 0)
+   {
+      if (option_cache[i].value && strcmp(option_cache[i].value, var->value) == 0)
+         return false;
+      free(option_cache[i].value);
+   }
+   else if (option_cache_count < OPTION_CACHE_MAX)
+   {
+      i = option_cache_count++;
+      option_cache[i].key = var->key;
+   }
+   else
+      return true;
+
+   option_cache[i].value = x_strdup(var->value);
+   return true;
+}
+
+#if !defined(__PET__) && !defined(__PLUS4__) && !defined(__VIC20__)
+/* Rebuilds the SID once, after both the engine and the model options of an
+ * update are known */
+static void update_sid(void)
+{
+   if (RETROSIDMODL == 0xff)
+      resources_set_int("SidEngine", RETROSIDENGINE);
+   else
+      sid_set_engine_model(RETROSIDENGINE, RETROSIDMODL);
+   snapshot_size_invalidate();
+}
+#endif
+
 static void update_variables(void)
 {
    struct retro_variable var;
    struct retro_core_option_display option_display;
+   bool options_display_changed = false;
 
    log_cb(RETRO_LOG_INFO, "Updating variables, UI finalized = %d\n", retro_ui_finalized);
 
+   /* The model setters change resources without log_resources_set_*() */
+   snapshot_size_invalidate();
+
    var.key = "vice_autostart";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (retro_ui_finalized)
       {
@@ -2473,7 +2718,7 @@ static void update_variables(void)
 
    var.key = "vice_drive_true_emulation";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (retro_ui_finalized)
       {
@@ -2482,12 +2727,14 @@ static void update_variables(void)
             RETROTDE=1;
             log_resources_set_int("DriveTrueEmulation", 1);
             log_resources_set_int("VirtualDevices", 0);
+            option_invalidate("vice_drive_sound_emulation");
          }
          else if (strcmp(var.value, "disabled") == 0 && RETROTDE == 1)
          {
             RETROTDE=0;
             log_resources_set_int("DriveTrueEmulation", 0);
             log_resources_set_int("VirtualDevices", 1);
+            option_invalidate("vice_drive_sound_emulation");
          }
       }
       else
@@ -2497,9 +2744,57 @@ static void update_variables(void)
       }
    }
 
+   var.key = "vice_drive_idle_skip";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      if (strcmp(var.value, "enabled") == 0) RETRODRIVEIDLESKIP=1;
+      else RETRODRIVEIDLESKIP=0;
+
+      if (retro_ui_finalized)
+         log_resources_set_int("Drive8IdleLoopSkip", RETRODRIVEIDLESKIP);
+   }
+
+   {
+      unsigned int rewind_seconds = 0;
+      unsigned int rewind_memory = 64;
+      bool rewind_changed = false;
+
+      var.key = "vice_rewind";
+      var.value = NULL;
+      rewind_changed |= option_changed(&var);
+      if (var.value)
+      {
+         if (strcmp(var.value, "disabled") == 0) rewind_seconds = 0;
+         else rewind_seconds = atoi(var.value);
+      }
+
+      var.key = "vice_rewind_memory";
+      var.value = NULL;
+      rewind_changed |= option_changed(&var);
+      if (var.value)
+      {
+         rewind_memory = atoi(var.value);
+      }
+
+      /* One state per frame, the ring keeps the history only if both the depth and the size allow */
+      if (rewind_changed)
+         rewind_init(rewind_seconds ? (size_t)rewind_memory * 1024 * 1024 : 0,
+                     (unsigned int)(rewind_seconds * (retro_region == RETRO_REGION_PAL ? C64_PAL_RFSH_PER_SEC : C64_NTSC_RFSH_PER_SEC)));
+   }
+
+   var.key = "vice_perf_counters";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      if (strcmp(var.value, "csv") == 0) retro_perf_init(environ_cb, RETRO_PERF_DUMP_CSV);
+      else if (strcmp(var.value, "json") == 0) retro_perf_init(environ_cb, RETRO_PERF_DUMP_JSON);
+      else retro_perf_init(environ_cb, RETRO_PERF_DUMP_NONE);
+   }
+
    var.key = "vice_drive_sound_emulation";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int val = atoi(var.value);
       val = val * 20;
@@ -2531,7 +2826,7 @@ static void update_variables(void)
 #if defined(__X64__) || defined(__X64SC__) || defined(__X128__) || defined(__VIC20__)
    var.key = "vice_audio_leak_emulation";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int audioleak=0;
 
@@ -2554,7 +2849,7 @@ static void update_variables(void)
 
    var.key = "vice_sound_sample_rate";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       RETROSOUNDSAMPLERATE=atoi(var.value);
    }
@@ -2562,7 +2857,7 @@ static void update_variables(void)
 #if defined(__VIC20__)
    var.key = "vice_vic20_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0;
 
@@ -2578,7 +2873,7 @@ static void update_variables(void)
 
    var.key = "vice_vic20_memory_expansions";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int vic20mem=0;
 
@@ -2651,7 +2946,7 @@ static void update_variables(void)
 #elif defined(__PLUS4__)
    var.key = "vice_plus4_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0;
 
@@ -2670,7 +2965,7 @@ static void update_variables(void)
 #elif defined(__X128__)
    var.key = "vice_c128_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0;
 
@@ -2680,14 +2975,19 @@ static void update_variables(void)
       else if (strcmp(var.value, "C128 DCR NTSC") == 0) modl=C128MODEL_C128DCR_NTSC;
 
       if (retro_ui_finalized && RETROC64MODL != modl)
+      {
          c128model_set(modl);
+         // The model brings its default SID, apply the SID model option again
+         option_invalidate("vice_sid_model");
+         request_update_sid = 1;
+      }
 
       RETROC64MODL=modl;
    }
 
    var.key = "vice_c128_video_output";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int c128columnkey=1;
 
@@ -2700,12 +3000,26 @@ static void update_variables(void)
          machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
       }
 
+      // Zoom depends on the video output
+      if (RETROC128COLUMNKEY != c128columnkey)
+         option_invalidate("vice_zoom_mode");
+
       RETROC128COLUMNKEY=c128columnkey;
    }
 
+#ifdef HAVE_THREADS
+   var.key = "vice_vdc_parallel";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      if (strcmp(var.value, "enabled") == 0) vdc_set_parallel_rendering(1);
+      else vdc_set_parallel_rendering(0);
+   }
+#endif
+
    var.key = "vice_c128_go64";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int c128go64=0;
 
@@ -2715,6 +3029,8 @@ static void update_variables(void)
       // Force VIC-II with GO64
       if (c128go64)
       {
+         if (RETROC128COLUMNKEY != 1)
+            option_invalidate("vice_zoom_mode");
          RETROC128COLUMNKEY=1;
          if (retro_ui_finalized)
             log_resources_set_int("C128ColumnKey", 1);
@@ -2731,7 +3047,7 @@ static void update_variables(void)
 #elif defined(__PET__)
    var.key = "vice_pet_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0;
 
@@ -2759,7 +3075,7 @@ static void update_variables(void)
 #elif defined(__CBM2__)
    var.key = "vice_cbm2_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0;
 
@@ -2783,7 +3099,7 @@ static void update_variables(void)
 #else
    var.key = "vice_c64_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0;
 
@@ -2802,7 +3118,12 @@ static void update_variables(void)
       else if (strcmp(var.value, "PET64 NTSC") == 0) modl=C64MODEL_PET64_NTSC;
 
       if (retro_ui_finalized && RETROC64MODL != modl)
+      {
          c64model_set(modl);
+         // The model brings its default SID, apply the SID model option again
+         option_invalidate("vice_sid_model");
+         request_update_sid = 1;
+      }
 
       RETROC64MODL=modl;
    }
@@ -2811,7 +3132,7 @@ static void update_variables(void)
 #if !defined(__PET__) && !defined(__PLUS4__) && !defined(__VIC20__)
    var.key = "vice_sid_engine";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int eng=0;
 
@@ -2820,19 +3141,18 @@ static void update_variables(void)
       else if (strcmp(var.value, "ReSID-FP") == 0) eng=7;
 
       if (retro_ui_finalized && RETROSIDENGINE != eng)
-      {
-         if (RETROSIDMODL == 0xff)
-            resources_set_int("SidEngine", eng);
-         else
-            sid_set_engine_model(eng, RETROSIDMODL);
-      }
+         request_update_sid = 1;
+
+      // 8580RD depends on the engine
+      if (RETROSIDENGINE != eng)
+         option_invalidate("vice_sid_model");
 
       RETROSIDENGINE=eng;
    }
 
    var.key = "vice_sid_model";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int modl=0xff;
 
@@ -2842,14 +3162,14 @@ static void update_variables(void)
       else if (strcmp(var.value, "8580RD") == 0) modl=(!RETROSIDENGINE ? 1 : 2);
 
       if (retro_ui_finalized && modl != 0xff)
-         sid_set_engine_model(RETROSIDENGINE, modl);
+         request_update_sid = 1;
 
       RETROSIDMODL=modl;
    }
 
    var.key = "vice_resid_sampling";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int resid=0;
 
@@ -2867,7 +3187,7 @@ static void update_variables(void)
    var.key = "vice_resid_passband";
    var.value = NULL;
 
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int val = atoi(var.value);
 
@@ -2883,7 +3203,7 @@ static void update_variables(void)
    var.key = "vice_resid_gain";
    var.value = NULL;
 
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int val = atoi(var.value);
 
@@ -2899,7 +3219,7 @@ static void update_variables(void)
    var.key = "vice_resid_filterbias";
    var.value = NULL;
 
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int val = atoi(var.value);
 
@@ -2912,7 +3232,7 @@ static void update_variables(void)
    var.key = "vice_resid_8580filterbias";
    var.value = NULL;
 
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int val = atoi(var.value);
 
@@ -2921,12 +3241,22 @@ static void update_variables(void)
 
       RETRORESID8580FILTERBIAS=val;
    }
+
+#ifdef HAVE_THREADS
+   var.key = "vice_sid_parallel";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      if (strcmp(var.value, "enabled") == 0) sound_set_parallel_synthesis(1);
+      else sound_set_parallel_synthesis(0);
+   }
+#endif
 #endif
 
 #if defined(__X64__) || defined(__X64SC__) || defined(__X128__) || defined(__VIC20__) || defined(__PLUS4__)
    var.key = "vice_zoom_mode";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "none") == 0) zoom_mode_id=0;
       else if (strcmp(var.value, "small") == 0) zoom_mode_id=1;
@@ -2943,7 +3273,7 @@ static void update_variables(void)
 
    var.key = "vice_zoom_mode_crop";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int zoom_mode_crop_id_prev = zoom_mode_crop_id;
 
@@ -2962,7 +3292,7 @@ static void update_variables(void)
 
    var.key = "vice_aspect_ratio";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int opt_aspect_ratio_prev = opt_aspect_ratio;
 
@@ -2978,7 +3308,7 @@ static void update_variables(void)
 
    var.key = "vice_manual_crop_top";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int manual_crop_top_prev = manual_crop_top;
       manual_crop_top = atoi(var.value);
@@ -2987,7 +3317,7 @@ static void update_variables(void)
    }
    var.key = "vice_manual_crop_bottom";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int manual_crop_bottom_prev = manual_crop_bottom;
       manual_crop_bottom = atoi(var.value);
@@ -2996,7 +3326,7 @@ static void update_variables(void)
    }
    var.key = "vice_manual_crop_left";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int manual_crop_left_prev = manual_crop_left;
       manual_crop_left = atoi(var.value);
@@ -3005,7 +3335,7 @@ static void update_variables(void)
    }
    var.key = "vice_manual_crop_right";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int manual_crop_right_prev = manual_crop_right;
       manual_crop_right = atoi(var.value);
@@ -3024,7 +3354,7 @@ static void update_variables(void)
 
    var.key = "vice_gfx_colors";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       // Only allow screenmode change after restart
       if (!pix_bytes_initialized)
@@ -3035,10 +3365,32 @@ static void update_variables(void)
       }
    }
 
+   var.key = "vice_frameskip";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      unsigned int frameskip = 0;
+      if (strcmp(var.value, "auto") == 0) frameskip = 1;
+      else if (strcmp(var.value, "manual") == 0) frameskip = 2;
+
+      if (frameskip != opt_frameskip)
+      {
+         opt_frameskip = frameskip;
+         request_update_frameskip = 1;
+      }
+   }
+
+   var.key = "vice_frameskip_threshold";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      opt_frameskip_threshold = atoi(var.value);
+   }
+
 #if defined(__VIC20__)
    var.key = "vice_vic20_external_palette";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       char extpal[20] = "";
       if (strcmp(var.value, "Default") == 0) sprintf(extpal, "%s", "");
@@ -3075,7 +3427,7 @@ static void update_variables(void)
 #elif defined(__PLUS4__)
    var.key = "vice_plus4_external_palette";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       char extpal[20] = "";
       if (strcmp(var.value, "Default") == 0) sprintf(extpal, "%s", "");
@@ -3111,7 +3463,7 @@ static void update_variables(void)
 #elif defined(__PET__)
    var.key = "vice_pet_external_palette";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       char extpal[20] = "";
       if (strcmp(var.value, "Default") == 0) sprintf(extpal, "%s", "");
@@ -3147,7 +3499,7 @@ static void update_variables(void)
 #elif defined(__CBM2__)
    var.key = "vice_cbm2_external_palette";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       char extpal[20] = "";
       if (strcmp(var.value, "Default") == 0) sprintf(extpal, "%s", "");
@@ -3183,7 +3535,7 @@ static void update_variables(void)
 #else
    var.key = "vice_external_palette";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (retro_ui_finalized)
       {
@@ -3209,7 +3561,7 @@ static void update_variables(void)
 
    var.key = "vice_vicii_color_gamma";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int color_gamma = atoi(var.value);
 
@@ -3221,7 +3573,7 @@ static void update_variables(void)
 
    var.key = "vice_vicii_color_saturation";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int color_saturation = atoi(var.value);
 
@@ -3233,7 +3585,7 @@ static void update_variables(void)
 
    var.key = "vice_vicii_color_contrast";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int color_contrast = atoi(var.value);
 
@@ -3245,7 +3597,7 @@ static void update_variables(void)
 
    var.key = "vice_vicii_color_brightness";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int color_brightness = atoi(var.value);
 
@@ -3258,7 +3610,7 @@ static void update_variables(void)
 
    var.key = "vice_userport_joytype";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       int joyadaptertype=-1;
       if (strcmp(var.value, "None") == 0) joyadaptertype=-1;
@@ -3286,7 +3638,7 @@ static void update_variables(void)
 #if !defined(__PET__) && !defined(__CBM2__) && !defined(__VIC20__)
    var.key = "vice_joyport";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "Port 2") == 0 && !cur_port_locked) cur_port=2;
       else if (strcmp(var.value, "Port 1") == 0 && !cur_port_locked) cur_port=1;
@@ -3294,35 +3646,35 @@ static void update_variables(void)
 
    var.key = "vice_joyport_type";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_joyport_type = atoi(var.value);
    }
 
    var.key = "vice_analogmouse_deadzone";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_analogmouse_deadzone = atoi(var.value);
    }
 
    var.key = "vice_analogmouse_speed";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_analogmouse_speed = atof(var.value);
    }
 
    var.key = "vice_dpadmouse_speed";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_dpadmouse_speed = atoi(var.value);
    }
 
    var.key = "vice_mouse_speed";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_mouse_speed = atoi(var.value);
    }
@@ -3331,7 +3683,7 @@ static void update_variables(void)
 
    var.key = "vice_keyrah_keypad_mappings";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) RETROKEYRAHKEYPAD=0;
       else if (strcmp(var.value, "enabled") == 0) RETROKEYRAHKEYPAD=1;
@@ -3339,7 +3691,7 @@ static void update_variables(void)
 
    var.key = "vice_physical_keyboard_pass_through";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) RETROKEYBOARDPASSTHROUGH=0;
       else if (strcmp(var.value, "enabled") == 0) RETROKEYBOARDPASSTHROUGH=1;
@@ -3347,7 +3699,7 @@ static void update_variables(void)
 
    var.key = "vice_retropad_options";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) opt_retropad_options=0;
       else if (strcmp(var.value, "rotate") == 0) opt_retropad_options=1;
@@ -3357,7 +3709,7 @@ static void update_variables(void)
 
    var.key = "vice_turbo_fire_button";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) turbo_fire_button=-1;
       else if (strcmp(var.value, "A") == 0) turbo_fire_button=RETRO_DEVICE_ID_JOYPAD_A;
@@ -3373,14 +3725,14 @@ static void update_variables(void)
 
    var.key = "vice_turbo_pulse";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       turbo_pulse=atoi(var.value);
    }
 
    var.key = "vice_reset";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "Autostart") == 0) RETRORESET=0;
       else if (strcmp(var.value, "Soft") == 0) RETRORESET=1;
@@ -3389,7 +3741,7 @@ static void update_variables(void)
 
    var.key = "vice_vkbd_theme";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       RETROTHEME=atoi(var.value);
       opt_vkbd_theme=RETROTHEME;
@@ -3397,7 +3749,7 @@ static void update_variables(void)
 
    var.key = "vice_vkbd_alpha";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_vkbd_alpha = 255 - (255 * atoi(var.value) / 100);
       vkbd_alpha = opt_vkbd_alpha;
@@ -3405,7 +3757,7 @@ static void update_variables(void)
 
    var.key = "vice_statusbar";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       opt_statusbar = 0;
 
@@ -3423,31 +3775,34 @@ static void update_variables(void)
 
    var.key = "vice_mapping_options_display";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) opt_mapping_options_display=0;
       else if (strcmp(var.value, "enabled") == 0) opt_mapping_options_display=1;
+      options_display_changed = true;
    }
 
    var.key = "vice_audio_options_display";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) opt_audio_options_display=0;
       else if (strcmp(var.value, "enabled") == 0) opt_audio_options_display=1;
+      options_display_changed = true;
    }
 
    var.key = "vice_video_options_display";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) opt_video_options_display=0;
       else if (strcmp(var.value, "enabled") == 0) opt_video_options_display=1;
+      options_display_changed = true;
    }
 
    var.key = "vice_read_vicerc";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "disabled") == 0) opt_read_vicerc=0;
       else if (strcmp(var.value, "enabled") == 0) opt_read_vicerc=1;
@@ -3457,6 +3812,7 @@ static void update_variables(void)
    }
 
 #if defined(__X64__) || defined(__X64SC__) || defined(__X128__)
+   /* Evaluated every time, the content decides whether JiffyDOS is allowed */
    var.key = "vice_jiffydos";
    var.value = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -3475,84 +3831,84 @@ static void update_variables(void)
    /* Mapper */
    var.key = "vice_mapper_select";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_SELECT] = keyId(var.value);
    }
 
    var.key = "vice_mapper_start";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_START] = keyId(var.value);
    }
 
    var.key = "vice_mapper_b";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_B] = keyId(var.value);
    }
 
    var.key = "vice_mapper_a";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_A] = keyId(var.value);
    }
 
    var.key = "vice_mapper_y";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_Y] = keyId(var.value);
    }
 
    var.key = "vice_mapper_x";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_X] = keyId(var.value);
    }
 
    var.key = "vice_mapper_l";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_L] = keyId(var.value);
    }
 
    var.key = "vice_mapper_r";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_R] = keyId(var.value);
    }
 
    var.key = "vice_mapper_l2";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_L2] = keyId(var.value);
    }
 
    var.key = "vice_mapper_r2";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_R2] = keyId(var.value);
    }
 
    var.key = "vice_mapper_l3";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_L3] = keyId(var.value);
    }
 
    var.key = "vice_mapper_r3";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[RETRO_DEVICE_ID_JOYPAD_R3] = keyId(var.value);
    }
@@ -3561,56 +3917,56 @@ static void update_variables(void)
 
    var.key = "vice_mapper_lr";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[16] = keyId(var.value);
    }
 
    var.key = "vice_mapper_ll";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[17] = keyId(var.value);
    }
 
    var.key = "vice_mapper_ld";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[18] = keyId(var.value);
    }
 
    var.key = "vice_mapper_lu";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[19] = keyId(var.value);
    }
 
    var.key = "vice_mapper_rr";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[20] = keyId(var.value);
    }
 
    var.key = "vice_mapper_rl";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[21] = keyId(var.value);
    }
 
    var.key = "vice_mapper_rd";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[22] = keyId(var.value);
    }
 
    var.key = "vice_mapper_ru";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[23] = keyId(var.value);
    }
@@ -3618,49 +3974,56 @@ static void update_variables(void)
 
    var.key = "vice_mapper_vkbd";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[24] = keyId(var.value);
    }
 
    var.key = "vice_mapper_statusbar";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[25] = keyId(var.value);
    }
 
    var.key = "vice_mapper_joyport_switch";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[26] = keyId(var.value);
    }
 
    var.key = "vice_mapper_reset";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[27] = keyId(var.value);
    }
 
    var.key = "vice_mapper_zoom_mode_toggle";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[28] = keyId(var.value);
    }
 
    var.key = "vice_mapper_warp_mode";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       mapper_keys[29] = keyId(var.value);
    }
 
+   var.key = "vice_mapper_rewind";
+   var.value = NULL;
+   if (option_changed(&var))
+   {
+      mapper_keys[30] = keyId(var.value);
+   }
+
    var.key = "vice_datasette_hotkeys";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
       if (strcmp(var.value, "enabled") == 0) datasette_hotkeys=1;
       else if (strcmp(var.value, "disabled") == 0) datasette_hotkeys=0;
@@ -3668,48 +4031,50 @@ static void update_variables(void)
 
    var.key = "vice_mapper_datasette_toggle_hotkeys";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
-      mapper_keys[30] = keyId(var.value);
+      mapper_keys[31] = keyId(var.value);
    }
    
    var.key = "vice_mapper_datasette_stop";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
-      mapper_keys[31] = keyId(var.value);
+      mapper_keys[32] = keyId(var.value);
    }
 
    var.key = "vice_mapper_datasette_start";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
-      mapper_keys[32] = keyId(var.value);
+      mapper_keys[33] = keyId(var.value);
    }
 
    var.key = "vice_mapper_datasette_forward";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
-      mapper_keys[33] = keyId(var.value);
+      mapper_keys[34] = keyId(var.value);
    }
 
    var.key = "vice_mapper_datasette_rewind";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
-      mapper_keys[34] = keyId(var.value);
+      mapper_keys[35] = keyId(var.value);
    }
 
    var.key = "vice_mapper_datasette_reset";
    var.value = NULL;
-   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   if (option_changed(&var))
    {
-      mapper_keys[35] = keyId(var.value);
+      mapper_keys[36] = keyId(var.value);
    }
 
 
    /*** Options display ***/
+   if (!options_display_changed)
+      return;
 
    /* Mapping options */
    option_display.visible = opt_mapping_options_display;
@@ -3770,6 +4135,8 @@ static void update_variables(void)
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "vice_mapper_warp_mode";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "vice_mapper_rewind";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "vice_mapper_datasette_toggle_hotkeys";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "vice_mapper_datasette_start";
@@ -3809,6 +4176,10 @@ static void update_variables(void)
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
    option_display.key = "vice_resid_8580filterbias";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+#ifdef HAVE_THREADS
+   option_display.key = "vice_sid_parallel";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+#endif
 #endif
 
    /* Video options */
@@ -3832,6 +4203,10 @@ static void update_variables(void)
 #endif
    option_display.key = "vice_gfx_colors";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "vice_frameskip";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   option_display.key = "vice_frameskip_threshold";
+   environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
 #if defined(__VIC20__)
    option_display.key = "vice_vic20_external_palette";
    environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
@@ -3898,6 +4273,7 @@ void emu_reset(void)
 void retro_reset(void)
 {
    microSecCounter = 0;
+   snapshot_size_invalidate();
 
    // Always stop datasette, or autostart from tape will fail
    datasette_control(DATASETTE_CONTROL_STOP);
@@ -3933,6 +4309,8 @@ static bool retro_set_eject_state(bool ejected)
         else
             dc->eject_state = ejected;
 
+        snapshot_size_invalidate();
+
         if (ejected && dc->index <= dc->count)
         {
             dc->eject_state = ejected;
@@ -4275,6 +4653,10 @@ void retro_init(void)
    }
 
    memset(retro_bmp, 0, sizeof(retro_bmp));
+   retro_render_full = 1;
+
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &retro_can_dupe))
+      retro_can_dupe = false;
    memset(core_key_state, 0, 512);
    memset(core_old_key_state, 0, sizeof(core_old_key_state));
 
@@ -4337,6 +4719,13 @@ void retro_deinit(void)
    if (core_options_legacy_strings)
       free(core_options_legacy_strings);
 
+   // Clean rewind history
+   rewind_deinit();
+   serialize_cache_free();
+
+   // Clean core option values
+   option_cache_reset();
+
    // Clean ZIP temp
    if (retro_temp_directory != NULL && path_is_directory(retro_temp_directory))
       remove_recurse(retro_temp_directory);
@@ -4671,17 +5060,101 @@ void retro_audio_batch_cb(const int16_t *data, size_t frames)
    audio_batch_cb(data, frames);
 }
 
-void retro_audio_render(signed short int *sound_buffer, int sndbufsize)
+void retro_audio_render(const int16_t *sound_buffer, size_t frames)
 {
-   int x;
-#if 1
-   for (x=0; x<sndbufsize; x++) audio_cb(sound_buffer[x], sound_buffer[x]);
-#else
-   //FIXME audio_batch_cb(sound_buffer, sndbufsize);
-#endif
+   /* Interleaved stereo from soundretro.c, the frontend may take less
+      than offered per call */
+   while (frames > 0)
+   {
+      size_t written = audio_batch_cb(sound_buffer, frames);
+      if (written == 0)
+         break;
+      sound_buffer += written * 2;
+      frames -= MIN(written, frames);
+   }
+}
+
+/* Frameskip only leaves out drawing the screen, so it is decided per frame
+   from how close the frontend's audio buffer is to running dry. Frontends
+   without the audio buffer status report the time between two retro_run()
+   calls instead. */
+#define FRAMESKIP_MAX 3
+
+static bool audio_buff_status = false;
+static bool audio_buff_active = false;
+static unsigned audio_buff_occupancy = 0;
+static bool audio_buff_underrun = false;
+static retro_usec_t frame_time_usec = 0;
+static unsigned int frameskip_counter = 0;
+
+static void retro_audio_buff_status_cb(bool active, unsigned occupancy, bool underrun_likely)
+{
+   audio_buff_active = active;
+   audio_buff_occupancy = occupancy;
+   audio_buff_underrun = underrun_likely;
+}
+
+static void retro_frame_time_cb(retro_usec_t usec)
+{
+   frame_time_usec = usec;
+}
+
+static retro_usec_t frame_time_reference(void)
+{
+   return (retro_usec_t)(1000000 / (retro_region == RETRO_REGION_NTSC ? C64_NTSC_RFSH_PER_SEC : C64_PAL_RFSH_PER_SEC));
 }
 
+static void update_frameskip(void)
+{
+   struct retro_audio_buffer_status_callback buf_status_cb;
+   unsigned int latency = 0;
+
+   audio_buff_status = false;
+   audio_buff_active = false;
+   frameskip_counter = 0;
 
+   if (opt_frameskip)
+   {
+      buf_status_cb.callback = retro_audio_buff_status_cb;
+      audio_buff_status = environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, &buf_status_cb);
+      if (audio_buff_status)
+         /* Enough audio for the frames skipped in a row */
+         latency = (unsigned int)(6 * frame_time_reference() / 1000);
+      else
+         log_cb(RETRO_LOG_WARN, "Frameskip: No audio buffer status, using frame time\n");
+   }
+   else
+      environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, NULL);
+
+   environ_cb(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &latency);
+}
+
+static bool frameskip_frame(void)
+{
+   bool skip = false;
+
+   if (!opt_frameskip)
+      return false;
+
+   if (audio_buff_status)
+      skip = audio_buff_active && (opt_frameskip == 1 ? audio_buff_underrun : audio_buff_occupancy < opt_frameskip_threshold);
+   else
+      skip = frame_time_usec > frame_time_reference() * 5 / 4;
+
+   /* Show a frame now and then even when the frontend never catches up */
+   if (skip && frameskip_counter < FRAMESKIP_MAX)
+   {
+      frameskip_counter++;
+      return true;
+   }
+   frameskip_counter = 0;
+   return false;
+}
+
+
+
+static void rewind_capture(void);
+static void rewind_step(void);
 
 void retro_run(void)
 {
@@ -4689,8 +5162,24 @@ void retro_run(void)
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
       update_variables();
 
+   /* Update audio buffer status callback if changed by core option */
+   if (request_update_frameskip)
+   {
+      request_update_frameskip = 0;
+      update_frameskip();
+   }
+
    if (retro_ui_finalized)
    {
+#if !defined(__PET__) && !defined(__PLUS4__) && !defined(__VIC20__)
+      /* Update SID if engine or model changed by core option */
+      if (request_update_sid)
+      {
+         request_update_sid = 0;
+         update_sid();
+      }
+#endif
+
       /* Update samplerate if changed by core option */
       if (prev_audio_sample_rate != RETROSOUNDSAMPLERATE)
       {
@@ -4759,6 +5248,20 @@ void retro_run(void)
    /* Input poll */
    retro_poll_event();
 
+   /* Step back one state while the rewind hotkey is held */
+   if (rewindmode && rewind_enabled())
+      rewind_step();
+
+   /* Frames the frontend throws away (run-ahead, secondary instance) are
+      emulated without rendering the screen or resampling the audio */
+   {
+      int av_enable = AV_ENABLE_VIDEO | AV_ENABLE_AUDIO;
+      if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable))
+         av_enable = AV_ENABLE_VIDEO | AV_ENABLE_AUDIO;
+      retro_av_enable = av_enable;
+      sound_set_discard_output(!(av_enable & AV_ENABLE_AUDIO) || (av_enable & AV_DISABLE_AUDIO));
+   }
+
    /* Measure frame-time and time between frames to render as much frames as possible when warp is enabled. Does not work
       perfectly as the time needed by the framework cannot be accounted, but should not reduce amount of actually rendered
       frames too much. */
@@ -4772,12 +5275,35 @@ void retro_run(void)
       retro_time_t t_begin=pcb.get_time_usec();
       retro_time_t t_interframe=MIN((t_end_prev ? t_begin-t_end_prev : 0), 20000-t_frame);
 
-      for (int frame_count=0;frame_count<(retro_warp_mode_enabled() ? (t_interframe+t_frame)/t_frame : 1);++frame_count)
+      int frames=(retro_warp_mode_enabled() ? (t_interframe+t_frame)/t_frame : 1);
+      bool skip=frameskip_frame();
+
+      /* The VKBD is drawn over retro_bmp, so it has to be redrawn from
+         scratch while it is shown and once it goes away */
+      static int prev_showkey = 0;
+      if (SHOWKEY==1 || prev_showkey==1)
+         retro_render_full = 1;
+      prev_showkey = SHOWKEY;
+      retro_frame_changed = 0;
+      RETRO_PERF_BEGIN(RETRO_PERF_FRAME);
+
+      for (int frame_count=0;frame_count<frames;++frame_count)
       {
-         while(cpuloop==1)
+         /* Only the last frame of a warp batch reaches the screen, the
+            others are emulated without drawing their lines */
+         retro_draw_frame = (retro_av_enable & AV_ENABLE_VIDEO) && frame_count == frames-1 && !skip;
+         retro_skip_frame(!retro_draw_frame);
+
+         /* Returns once vsyncarch_presync() has cleared cpuloop */
+         if (cpuloop)
             maincpu_mainloop_retro();
          cpuloop=1;
 
+#if defined(__X128__)
+         /* The VDC lines emulated after the frame ended may still be drawn */
+         vdc_finish_drawing();
+#endif
+
          if (!frame_count)
          {
             retro_time_t t_end=pcb.get_time_usec();
@@ -4788,10 +5314,16 @@ void retro_run(void)
                t_frame=20000;
          }
       }
+
+      RETRO_PERF_END(RETRO_PERF_FRAME);
+      retro_perf_frame(maincpu_clk);
    }
 
+   if (!rewindmode && rewind_enabled())
+      rewind_capture();
+
    /* Show VKBD */
-   if (SHOWKEY==1)
+   if (SHOWKEY==1 && (retro_av_enable & AV_ENABLE_VIDEO))
       print_virtual_kbd(retro_bmp);
 
    /* Finalize zoom offsets */
@@ -4813,7 +5345,18 @@ void retro_run(void)
    if (imagename_timer > 0)
       imagename_timer--;
 
-   video_cb(retro_bmp+(retroXS_offset*pix_bytes/2)+(retroYS_offset*(retroW<<(pix_bytes/4))), zoomed_width, zoomed_height, retroW<<(pix_bytes/2));
+   /* Nothing was rendered and the visible area is the same, let the frontend
+      show the previous frame again */
+   {
+      static unsigned int prev_video[4];
+      unsigned int video[4] = { retroXS_offset, retroYS_offset, zoomed_width, zoomed_height };
+
+      if (retro_can_dupe && !retro_frame_changed && SHOWKEY!=1 && !memcmp(video, prev_video, sizeof(video)))
+         video_cb(NULL, zoomed_width, zoomed_height, retroW<<(pix_bytes/2));
+      else
+         video_cb(retro_bmp+(retroXS_offset*pix_bytes/2)+(retroYS_offset*(retroW<<(pix_bytes/4))), zoomed_width, zoomed_height, retroW<<(pix_bytes/2));
+      memcpy(prev_video, video, sizeof(video));
+   }
    microSecCounter += (1000000/(retro_region == RETRO_REGION_NTSC ? C64_NTSC_RFSH_PER_SEC : C64_PAL_RFSH_PER_SEC));
 }
 
@@ -4824,8 +5367,19 @@ bool retro_load_game(const struct retro_game_info *info)
       process_cmdline(info->path);
    }
 
+   snapshot_size_invalidate();
+   rewind_reset();
+   serialize_cache_invalidate();
    update_variables();
 
+   /* Fallback for frameskip */
+   {
+      struct retro_frame_time_callback frame_time_cb;
+      frame_time_cb.callback = retro_frame_time_cb;
+      frame_time_cb.reference = frame_time_reference();
+      environ_cb(RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK, &frame_time_cb);
+   }
+
 #if defined(__VIC20__)
    /* Moved this here so it also applies without loading content */
    cur_port = 1;
@@ -4853,6 +5407,10 @@ void retro_unload_game(void)
    dc_reset(dc);
    free(autostartString);
    autostartString = NULL;
+
+   char perf_path[RETRO_PATH_MAX];
+   snprintf(perf_path, sizeof(perf_path), "%s%svice_%s_perf", retro_save_directory, FSDEV_DIR_SEP_STR, CORE_NAME);
+   retro_perf_dump(perf_path);
 }
 
 unsigned retro_get_region(void)
@@ -4882,103 +5440,199 @@ bool retro_load_game_special(unsigned type, const struct retro_game_info *info,
    return false;
 }
 
-/* CPU traps ensure we are never saving snapshots or loading them in the middle of a cpu instruction.
-   Without this, savestate corruption occurs.
+/* retro_run() only returns between two opcodes, when vsyncarch_presync() has
+   ended the frame, so snapshots are written and read right here instead of
+   scheduling a CPU trap and emulating until it fires. Between two frames the
+   CPU registers are in maincpu_regs, where the snapshot modules find them.
 */
 
-static void save_trap(uint16_t addr, void *success)
+static int save_state(snapshot_stream_t *stream)
 {
    int save_disks;
    int drive_type;
    resources_get_int("Drive8Type", &drive_type);
    save_disks = (drive_type < 1550) ? 1 : 0;
 
+#ifndef __XSCPU64__
+   /* Serve the alarms due at the frame boundary, as the next opcode would
+      do first. Otherwise a module write dispatches them, and cycles stolen
+      by sprite DMA move the clock after the CPU module is written */
+   while (maincpu_clk >= alarm_context_next_pending_clk(maincpu_alarm_context))
+      alarm_context_dispatch(maincpu_alarm_context, maincpu_clk);
+#endif
+
    /* params: stream, save_roms, save_disks, event_mode */
-   if (machine_write_snapshot_to_stream(snapshot_stream, 0, save_disks, 0) >= 0)
-      *((int *)success) = 1;
-   else
-      *((int *)success) = 0;
-   save_trap_happened = 1;
+   return machine_write_snapshot_to_stream(stream, 0, save_disks, 0);
 }
 
-static void load_trap(uint16_t addr, void *success)
+static int load_state(snapshot_stream_t *stream)
 {
    /* params: stream, event_mode */
-   if (machine_read_snapshot_from_stream(snapshot_stream, 0) >= 0)
-      *((int *)success) = 1;
-   else
-      *((int *)success) = 0;
-   load_trap_happened = 1;
+   return machine_read_snapshot_from_stream(stream, 0);
+}
+
+void snapshot_size_invalidate(void)
+{
+   snapshot_size_cached = 0;
 }
 
 size_t retro_serialize_size(void)
 {
-   long snapshot_size = 0;
    if (retro_ui_finalized)
    {
-      snapshot_stream = snapshot_memory_write_fopen(NULL, 0);
-      int success = 0;
-      interrupt_maincpu_trigger_trap(save_trap, (void *)&success);
-      save_trap_happened = 0;
-      while (!save_trap_happened)
-         maincpu_mainloop_retro();
+      if (snapshot_size_cached)
+         return snapshot_size_cached;
+
+      snapshot_stream_t *snapshot_stream = snapshot_memory_write_fopen(NULL, 0);
       if (snapshot_stream != NULL)
       {
-         if (success)
+         if (save_state(snapshot_stream) >= 0)
          {
             snapshot_fseek(snapshot_stream, 0, SEEK_END);
-            snapshot_size = snapshot_ftell(snapshot_stream);
+            snapshot_size_cached = snapshot_ftell(snapshot_stream);
+#ifdef RETRO_DEBUG
+            log_cb(RETRO_LOG_INFO, "Snapshot size %u\n", (unsigned int)snapshot_size_cached);
+#endif
          }
          else
          {
             log_cb(RETRO_LOG_INFO, "Failed to calculate snapshot size\n");
          }
          snapshot_fclose(snapshot_stream);
-         snapshot_stream = NULL;
       }
    }
-   return snapshot_size;
+   return snapshot_size_cached;
 }
 
-bool retro_serialize(void *data_, size_t size)
+/* Fast savestates (run-ahead, frontend rewind, netplay) are never stored,
+   and the frontend passes the same few buffers again, so the payloads
+   still unchanged in them are not written again, like in the core rewind.
+   A buffer freed and allocated again at the same address is caught by its
+   header, a frontend writing another state into it is not */
+#define SERIALIZE_CACHES 2
+#define SERIALIZE_CACHE_HEADER 64
+
+static struct serialize_cache
+{
+   const void *data;
+   size_t size;
+   uint8_t header[SERIALIZE_CACHE_HEADER];
+   snapshot_memory_cache_t *cache;
+} serialize_caches[SERIALIZE_CACHES];
+static unsigned serialize_cache_next = 0;
+
+static void serialize_cache_invalidate(void)
+{
+   unsigned i;
+   for (i = 0; i < SERIALIZE_CACHES; i++)
+      serialize_caches[i].data = NULL;
+}
+
+static void serialize_cache_free(void)
+{
+   unsigned i;
+   for (i = 0; i < SERIALIZE_CACHES; i++)
+   {
+      if (serialize_caches[i].cache)
+         snapshot_memory_cache_free(serialize_caches[i].cache);
+      serialize_caches[i].cache = NULL;
+      serialize_caches[i].data = NULL;
+   }
+}
+
+static bool serialize_fast(size_t size)
+{
+   int av_enable = 0;
+   return size >= SERIALIZE_CACHE_HEADER
+         && environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable)
+         && (av_enable & AV_FAST_SAVESTATES);
+}
+
+static struct serialize_cache *serialize_cache_find(const void *data_, size_t size)
+{
+   unsigned i;
+   for (i = 0; i < SERIALIZE_CACHES; i++)
+      if (serialize_caches[i].data == data_ && serialize_caches[i].size == size
+            && !memcmp(serialize_caches[i].header, data_, SERIALIZE_CACHE_HEADER))
+         return &serialize_caches[i];
+   return NULL;
+}
+
+static bool serialize_to(void *data_, size_t size, snapshot_memory_cache_t *cache)
 {
    if (retro_ui_finalized)
    {
-      snapshot_stream = snapshot_memory_write_fopen(data_, size);
+      snapshot_stream_t *snapshot_stream = cache ? snapshot_memory_write_cached_fopen(data_, size, cache) : snapshot_memory_write_fopen(data_, size);
       int success = 0;
-      interrupt_maincpu_trigger_trap(save_trap, (void *)&success);
-      save_trap_happened = 0;
-      while (!save_trap_happened)
-         maincpu_mainloop_retro();
       if (snapshot_stream != NULL)
       {
+         if (save_state(snapshot_stream) >= 0)
+         {
+            /* Clear the rest of a larger buffer, so that the module search on
+               load stops at the end of the snapshot instead of stale data */
+            snapshot_fseek(snapshot_stream, 0, SEEK_END);
+            long snapshot_size = snapshot_ftell(snapshot_stream);
+            if ((size_t)snapshot_size < size)
+               memset((uint8_t *)data_ + snapshot_size, 0, size - snapshot_size);
+            /* Devices dropped by the machine itself shrink the snapshot */
+            if ((size_t)snapshot_size != snapshot_size_cached)
+               snapshot_size_invalidate();
+            success = 1;
+         }
          snapshot_fclose(snapshot_stream);
-         snapshot_stream = NULL;
       }
       if (success)
       {
          return true;
       }
+      /* Snapshot outgrew the cached size, measure again on next request */
+      snapshot_size_invalidate();
       log_cb(RETRO_LOG_INFO, "Failed to serialize snapshot\n");
    }
    return false;
 }
 
+bool retro_serialize(void *data_, size_t size)
+{
+   bool fast = serialize_fast(size);
+   struct serialize_cache *c = fast ? serialize_cache_find(data_, size) : NULL;
+
+   /* Another fast savestate buffer replaces the older one */
+   if (fast && !c)
+   {
+      c = &serialize_caches[serialize_cache_next];
+      serialize_cache_next = (serialize_cache_next + 1) % SERIALIZE_CACHES;
+      if (!c->cache)
+         c->cache = snapshot_memory_cache_new();
+      snapshot_memory_cache_invalidate(c->cache);
+      c->data = data_;
+      c->size = size;
+   }
+
+   if (!c)
+      return serialize_to(data_, size, NULL);
+
+   if (serialize_to(data_, size, c->cache))
+   {
+      memcpy(c->header, data_, SERIALIZE_CACHE_HEADER);
+      return true;
+   }
+   c->data = NULL;
+   return false;
+}
+
 bool retro_unserialize(const void *data_, size_t size)
 {
    if (retro_ui_finalized)
    {
       resources_set_int("WarpMode", 0);
-      snapshot_stream = snapshot_memory_read_fopen(data_, size);
+      snapshot_stream_t *snapshot_stream = snapshot_memory_read_fopen(data_, size);
       int success = 0;
-      interrupt_maincpu_trigger_trap(load_trap, (void *)&success);
-      load_trap_happened = 0;
-      while (!load_trap_happened)
-         maincpu_mainloop_retro();
       if (snapshot_stream != NULL)
       {
+         if (load_state(snapshot_stream) >= 0)
+            success = 1;
          snapshot_fclose(snapshot_stream);
-         snapshot_stream = NULL;
       }
       if (success)
       {
@@ -4989,6 +5643,35 @@ bool retro_unserialize(const void *data_, size_t size)
    return false;
 }
 
+/* Record the state at the end of each frame shown, frames run ahead with
+   audio and video disabled are not part of the history. The rewind buffer
+   still holds the state before last, so unchanged memory expansions are
+   not written again */
+static void rewind_capture(void)
+{
+   size_t size;
+   uint8_t *buffer;
+
+   if (!(retro_av_enable & AV_ENABLE_VIDEO))
+      return;
+
+   size = retro_serialize_size();
+   if (!size || !(buffer = rewind_state_buffer(size)))
+      return;
+
+   if (serialize_to(buffer, size, rewind_state_cache()))
+      rewind_push(size);
+}
+
+static void rewind_step(void)
+{
+   size_t size;
+   const uint8_t *state = rewind_pop(&size);
+
+   if (state)
+      retro_unserialize(state, size);
+}
+
 void *retro_get_memory_data(unsigned id)
 {
    if (id == RETRO_MEMORY_SYSTEM_RAM)
@@ -100,6 +100,11 @@ extern int vkbd_y_max;
 #define STATUSBAR_TOP       0x02
 #define STATUSBAR_BASIC     0x04
 #define STATUSBAR_MINIMAL   0x08
+//AUDIO/VIDEO ENABLE
+#define AV_ENABLE_VIDEO     0x01
+#define AV_ENABLE_AUDIO     0x02
+#define AV_FAST_SAVESTATES  0x04
+#define AV_DISABLE_AUDIO    0x08
 
 //VARIABLES
 extern int cpuloop;
@@ -118,10 +123,16 @@ extern unsigned int opt_statusbar;
 extern unsigned int cur_port;
 extern unsigned int retro_region;
 extern int RETROUSERPORTJOY;
+extern int retro_av_enable;
+extern int retro_draw_frame;
+extern int retro_render_full;
+extern int retro_frame_changed;
 
 //FUNCS
 extern void maincpu_mainloop_retro(void);
+extern void retro_skip_frame(int skip);
 extern long GetTicks(void);
+extern void snapshot_size_invalidate(void);
 
 enum {
 	RUNSTATE_FIRST_START = 0,
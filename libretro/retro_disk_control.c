@@ -28,6 +28,7 @@
 #include "attach.h"
 #include "drive.h"
 #include "tape.h"
+#include "zfile.h"
 #include "resources.h"
 
 #include <stdio.h>
@@ -119,7 +120,7 @@ static char* get_label(const char* filename)
     // Disk image which we can read name from
     if (strendswith(filename, "d64") || strendswith(filename, "d71"))
     {
-        FILE* fd = fopen(filename, "rb");
+        FILE* fd = zfile_fopen(filename, "rb");
 
         if (fd != NULL)
         {
@@ -129,14 +130,14 @@ static char* get_label(const char* filename)
                 label[D64_FULL_NAME_LEN] = '\0';
                 have_disk_label = true;
             }
-            fclose(fd);
+            zfile_fclose(fd);
         }
     }
 
     // Tape image which we can read name from
     if (strendswith(filename, "t64"))
     {
-        FILE* fd = fopen(filename, "rb");
+        FILE* fd = zfile_fopen(filename, "rb");
 
         if (fd != NULL)
         {
@@ -146,7 +147,7 @@ static char* get_label(const char* filename)
                 label[T64_NAME_LEN] = '\0';
                 have_tape_label = true;
             }
-            fclose(fd);
+            zfile_fclose(fd);
         }
     }
 
@@ -471,8 +472,15 @@ bool dc_replace_file(dc_storage* dc, int index, const char* filename)
             snprintf(full_path_replace, sizeof(full_path_replace), "%s", nib_output);
         }
 
+        // ZIP with a single disk or tape image, uncompress into memory
+        char zip_image[RETRO_PATH_MAX] = {0};
+        if (strendswith(full_path_replace, "zip")
+         && zip_uncompress_memory(full_path_replace, zip_path, NULL, zip_image) == 0)
+        {
+            snprintf(full_path_replace, sizeof(full_path_replace), "%s", zip_image);
+        }
         // ZIP
-        if (strendswith(full_path_replace, "zip"))
+        else if (strendswith(full_path_replace, "zip"))
         {
             path_mkdir(zip_path);
             zip_uncompress(full_path_replace, zip_path, NULL);
@@ -0,0 +1,233 @@
+/* Copyright (C) 2018 
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "retro_perf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Frames kept for the dump, about two hours at 50Hz
+#define PERF_FRAMES_MAX (2 * 60 * 60 * 50)
+
+// Columns of a recorded frame, the subsystem ticks follow in counter order
+// with the CPU core in place of the whole frame
+enum
+{
+    COL_USEC = 0,
+    COL_CYCLES,
+    COL_TICKS,
+    COLUMNS = COL_TICKS + RETRO_PERF_COUNTERS
+};
+
+static const char* const counter_names[RETRO_PERF_COUNTERS] =
+{
+    RETRO_PERF_COUNTER_NAMES
+};
+
+bool retro_perf_active = false;
+
+static struct retro_perf_callback perf_cb;
+static struct retro_perf_counter counters[RETRO_PERF_COUNTERS] =
+{
+    { "vice_raster" }, { "vice_sid" }, { "vice_drive" },
+    { "vice_render" }, { "vice_statusbar" }, { "vice_vdc_worker" },
+    { "vice_frame" }
+};
+static int perf_dump = RETRO_PERF_DUMP_NONE;
+
+static retro_perf_tick_t last_total[RETRO_PERF_COUNTERS];
+static retro_time_t last_usec = 0;
+static unsigned long last_clk = 0;
+
+static unsigned long long* frames = NULL;
+static unsigned frames_count = 0;
+static unsigned frames_alloc = 0;
+
+void retro_perf_init(retro_environment_t cb, int dump)
+{
+    unsigned i;
+
+    if (dump == perf_dump)
+        return;
+    perf_dump = dump;
+
+    if (dump != RETRO_PERF_DUMP_NONE && !perf_cb.get_perf_counter)
+    {
+        if (!cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf_cb) || !perf_cb.get_perf_counter)
+            memset(&perf_cb, 0, sizeof(perf_cb));
+        else if (perf_cb.perf_register)
+        {
+            // Shown in the frontend's own counter list as well
+            for (i = 0; i < RETRO_PERF_COUNTERS; i++)
+                perf_cb.perf_register(&counters[i]);
+        }
+    }
+
+    retro_perf_active = dump != RETRO_PERF_DUMP_NONE && perf_cb.get_perf_counter;
+    last_usec = 0;
+}
+
+void retro_perf_start(unsigned id)
+{
+    counters[id].start = perf_cb.get_perf_counter();
+}
+
+void retro_perf_stop(unsigned id)
+{
+    counters[id].total += perf_cb.get_perf_counter() - counters[id].start;
+    counters[id].call_cnt++;
+}
+
+retro_perf_tick_t retro_perf_ticks(void)
+{
+    return perf_cb.get_perf_counter();
+}
+
+void retro_perf_add(unsigned id, retro_perf_tick_t ticks, unsigned calls)
+{
+    counters[id].total += ticks;
+    counters[id].call_cnt += calls;
+}
+
+static bool grow_frames(void)
+{
+    unsigned n;
+    unsigned long long* p;
+
+    if (frames_count < frames_alloc)
+        return true;
+
+    n = frames_alloc ? frames_alloc * 2 : 4096;
+    p = (unsigned long long*)realloc(frames, (size_t)n * COLUMNS * sizeof(*frames));
+    if (p == NULL)
+        return false;
+
+    frames = p;
+    frames_alloc = n;
+    return true;
+}
+
+void retro_perf_frame(unsigned long clk)
+{
+    retro_time_t usec;
+    unsigned i;
+
+    if (!retro_perf_active)
+        return;
+
+    usec = perf_cb.get_time_usec ? perf_cb.get_time_usec() : 0;
+    if (last_usec && frames_count < PERF_FRAMES_MAX && grow_frames())
+    {
+        unsigned long long* row = frames + (size_t)frames_count * COLUMNS;
+        retro_perf_tick_t others = 0;
+
+        row[COL_USEC] = usec - last_usec;
+        // The clock is moved back now and then to prevent overflows
+        row[COL_CYCLES] = (clk >= last_clk) ? clk - last_clk : 0;
+        for (i = 0; i < RETRO_PERF_COUNTERS; i++)
+        {
+            row[COL_TICKS + i] = counters[i].total - last_total[i];
+            // The worker thread is not part of the frame
+            if (i != RETRO_PERF_FRAME && i != RETRO_PERF_VDC_WORKER)
+                others += row[COL_TICKS + i];
+        }
+        row[COL_TICKS + RETRO_PERF_FRAME] = (row[COL_TICKS + RETRO_PERF_FRAME] > others)
+                                          ? row[COL_TICKS + RETRO_PERF_FRAME] - others : 0;
+        frames_count++;
+    }
+
+    for (i = 0; i < RETRO_PERF_COUNTERS; i++)
+        last_total[i] = counters[i].total;
+    last_usec = usec;
+    last_clk = clk;
+}
+
+static void dump_csv(FILE* fp)
+{
+    unsigned f, i;
+
+    fprintf(fp, "frame,usec,cycles");
+    for (i = 0; i < RETRO_PERF_COUNTERS; i++)
+        fprintf(fp, ",%s", counter_names[i]);
+    fprintf(fp, "\n");
+
+    for (f = 0; f < frames_count; f++)
+    {
+        const unsigned long long* row = frames + (size_t)f * COLUMNS;
+        fprintf(fp, "%u", f);
+        for (i = 0; i < COLUMNS; i++)
+            fprintf(fp, ",%llu", row[i]);
+        fprintf(fp, "\n");
+    }
+}
+
+static void dump_json(FILE* fp)
+{
+    unsigned long long sum[COLUMNS] = { 0 };
+    unsigned f, i;
+
+    for (f = 0; f < frames_count; f++)
+        for (i = 0; i < COLUMNS; i++)
+            sum[i] += frames[(size_t)f * COLUMNS + i];
+
+    fprintf(fp, "{\n  \"frames\": %u,\n  \"usec\": %llu,\n  \"cycles\": %llu,\n  \"ticks\": {",
+            frames_count, sum[COL_USEC], sum[COL_CYCLES]);
+    for (i = 0; i < RETRO_PERF_COUNTERS; i++)
+        fprintf(fp, "%s\n    \"%s\": %llu", i ? "," : "", counter_names[i], sum[COL_TICKS + i]);
+    fprintf(fp, "\n  },\n  \"columns\": [\"usec\", \"cycles\"");
+    for (i = 0; i < RETRO_PERF_COUNTERS; i++)
+        fprintf(fp, ", \"%s\"", counter_names[i]);
+    fprintf(fp, "],\n  \"per_frame\": [");
+
+    for (f = 0; f < frames_count; f++)
+    {
+        const unsigned long long* row = frames + (size_t)f * COLUMNS;
+        fprintf(fp, "%s\n    [", f ? "," : "");
+        for (i = 0; i < COLUMNS; i++)
+            fprintf(fp, "%s%llu", i ? ", " : "", row[i]);
+        fprintf(fp, "]");
+    }
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+void retro_perf_dump(const char* path)
+{
+    char filename[4096];
+    FILE* fp;
+
+    if (perf_dump != RETRO_PERF_DUMP_NONE && frames_count)
+    {
+        snprintf(filename, sizeof(filename), "%s.%s", path,
+                 (perf_dump == RETRO_PERF_DUMP_JSON) ? "json" : "csv");
+        if ((fp = fopen(filename, "w")) != NULL)
+        {
+            if (perf_dump == RETRO_PERF_DUMP_JSON)
+                dump_json(fp);
+            else
+                dump_csv(fp);
+            fclose(fp);
+        }
+    }
+
+    free(frames);
+    frames = NULL;
+    frames_count = 0;
+    frames_alloc = 0;
+    last_usec = 0;
+}
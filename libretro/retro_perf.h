@@ -0,0 +1,76 @@
+/* Copyright (C) 2018 
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RETRO_PERF_H__
+#define RETRO_PERF_H__
+
+#include <stdbool.h>
+
+#include "libretro.h"
+
+//*****************************************************************************
+// Per-frame profiling split by subsystem, using the frontend perf counters.
+// The CPU core is not measured directly, it is the frame time left after all
+// other subsystems, which all run from inside the CPU loop. The counters are
+// only started and stopped on the main thread. The VDC worker thread times the
+// lines it draws itself, they are added up once the worker is waited for and
+// run alongside the frame, not as part of it.
+
+enum
+{
+    RETRO_PERF_RASTER = 0,
+    RETRO_PERF_SID,
+    RETRO_PERF_DRIVE,
+    RETRO_PERF_RENDER,
+    RETRO_PERF_STATUSBAR,
+    RETRO_PERF_VDC_WORKER,
+    RETRO_PERF_FRAME,
+    RETRO_PERF_COUNTERS
+};
+
+// Names of the counters in the dumps, in counter order. The whole frame is
+// reported as the CPU core, the time left after the other subsystems.
+#define RETRO_PERF_COUNTER_NAMES \
+    "raster", "sid", "drive", "render", "statusbar", "vdc_worker", "cpu"
+
+enum
+{
+    RETRO_PERF_DUMP_NONE = 0,
+    RETRO_PERF_DUMP_CSV,
+    RETRO_PERF_DUMP_JSON
+};
+
+extern bool retro_perf_active;
+
+// Select the dump format, RETRO_PERF_DUMP_NONE turns profiling off
+void retro_perf_init(retro_environment_t cb, int dump);
+void retro_perf_start(unsigned id);
+void retro_perf_stop(unsigned id);
+// Current ticks, for counting on another thread
+retro_perf_tick_t retro_perf_ticks(void);
+// Add 'ticks' counted on another thread over 'calls' calls
+void retro_perf_add(unsigned id, retro_perf_tick_t ticks, unsigned calls);
+// Record the counters of the frame just run together with the main CPU clock
+void retro_perf_frame(unsigned long clk);
+// Write the recorded frames to 'path' without extension and start over
+void retro_perf_dump(const char* path);
+
+#define RETRO_PERF_BEGIN(id) do { if (retro_perf_active) retro_perf_start(id); } while (0)
+#define RETRO_PERF_END(id)   do { if (retro_perf_active) retro_perf_stop(id); } while (0)
+
+#endif
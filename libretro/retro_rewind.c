@@ -0,0 +1,336 @@
+/* Copyright (C) 2018 
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "retro_rewind.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Zero runs shorter than this are kept inside the literal, so that every
+// token header is paid for by at least as many skipped bytes
+#define REWIND_MIN_SKIP 8
+
+struct rewind_entry
+{
+    size_t offset;      // Position of the delta in the ring
+    size_t length;      // Encoded length of the delta
+    size_t state_size;  // Size of the state the delta leads back to
+};
+
+static uint8_t* ring = NULL;
+static size_t ring_size = 0;
+static size_t ring_pos = 0;
+
+static struct rewind_entry* entries = NULL;
+static unsigned entries_max = 0;
+static unsigned entries_first = 0;
+static unsigned entries_count = 0;
+
+// Newest state and the buffer the next one is serialized into. Both are
+// kept zero beyond their state size, so states of different sizes can be
+// XORed over the larger length.
+static uint8_t* head = NULL;
+static size_t head_size = 0;
+static size_t head_alloc = 0;
+static bool head_valid = false;
+static snapshot_memory_cache_t* head_cache = NULL;
+
+static uint8_t* next = NULL;
+static size_t next_used = 0;
+static size_t next_alloc = 0;
+static snapshot_memory_cache_t* next_cache = NULL;
+
+static uint8_t* delta = NULL;
+static size_t delta_alloc = 0;
+
+static bool grow(uint8_t** buf, size_t* alloc, size_t size)
+{
+    uint8_t* p;
+
+    if (size <= *alloc)
+        return true;
+
+    p = (uint8_t*)realloc(*buf, size);
+    if (p == NULL)
+        return false;
+
+    memset(p + *alloc, 0, size - *alloc);
+    *buf = p;
+    *alloc = size;
+    return true;
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Encode 'a' XOR 'b' as a series of (skip, literal length, literal) tokens
+static size_t delta_encode(const uint8_t* a, const uint8_t* b, size_t n, uint8_t* out)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < n)
+    {
+        size_t skip_start = i;
+        size_t lit_start;
+        unsigned zeros = 0;
+
+        // Unchanged bytes, a word at a time where possible
+        while (i + sizeof(uint64_t) <= n)
+        {
+            uint64_t wa, wb;
+            memcpy(&wa, a + i, sizeof(wa));
+            memcpy(&wb, b + i, sizeof(wb));
+            if (wa != wb)
+                break;
+            i += sizeof(uint64_t);
+        }
+        while (i < n && a[i] == b[i])
+            i++;
+
+        // Changed bytes up to the next long enough unchanged run
+        lit_start = i;
+        while (i < n)
+        {
+            if (a[i] != b[i])
+                zeros = 0;
+            else if (++zeros == REWIND_MIN_SKIP)
+            {
+                i -= REWIND_MIN_SKIP - 1;
+                break;
+            }
+            i++;
+        }
+
+        put_u32(out + o, (uint32_t)(lit_start - skip_start));
+        put_u32(out + o + 4, (uint32_t)(i - lit_start));
+        o += 8;
+        for (size_t j = lit_start; j < i; j++)
+            out[o++] = a[j] ^ b[j];
+    }
+
+    return o;
+}
+
+static void delta_apply(uint8_t* state, const uint8_t* in, size_t length)
+{
+    size_t pos = 0;
+    size_t o = 0;
+
+    while (o < length)
+    {
+        uint32_t skip = get_u32(in + o);
+        uint32_t lit = get_u32(in + o + 4);
+        o += 8;
+        pos += skip;
+        for (uint32_t j = 0; j < lit; j++)
+            state[pos++] ^= in[o++];
+    }
+}
+
+static void drop_oldest(void)
+{
+    entries_first = (entries_first + 1) % entries_max;
+    entries_count--;
+}
+
+void rewind_init(size_t budget, unsigned depth)
+{
+    if (budget == ring_size && depth == entries_max)
+        return;
+
+    rewind_deinit();
+    if (budget == 0 || depth == 0)
+        return;
+
+    ring = (uint8_t*)malloc(budget);
+    entries = (struct rewind_entry*)calloc(depth, sizeof(struct rewind_entry));
+    if (ring == NULL || entries == NULL)
+    {
+        rewind_deinit();
+        return;
+    }
+    ring_size = budget;
+    entries_max = depth;
+
+    head_cache = snapshot_memory_cache_new();
+    next_cache = snapshot_memory_cache_new();
+}
+
+void rewind_deinit(void)
+{
+    free(ring);
+    ring = NULL;
+    ring_size = 0;
+    free(entries);
+    entries = NULL;
+    entries_max = 0;
+
+    free(head);
+    head = NULL;
+    head_alloc = 0;
+    free(next);
+    next = NULL;
+    next_alloc = 0;
+    free(delta);
+    delta = NULL;
+    delta_alloc = 0;
+
+    if (head_cache)
+        snapshot_memory_cache_free(head_cache);
+    head_cache = NULL;
+    if (next_cache)
+        snapshot_memory_cache_free(next_cache);
+    next_cache = NULL;
+
+    rewind_reset();
+}
+
+void rewind_reset(void)
+{
+    ring_pos = 0;
+    entries_first = 0;
+    entries_count = 0;
+    head_valid = false;
+    head_size = 0;
+    next_used = 0;
+    if (head)
+        memset(head, 0, head_alloc);
+    if (next)
+        memset(next, 0, next_alloc);
+    if (head_cache)
+        snapshot_memory_cache_invalidate(head_cache);
+    if (next_cache)
+        snapshot_memory_cache_invalidate(next_cache);
+}
+
+bool rewind_enabled(void)
+{
+    return ring != NULL;
+}
+
+uint8_t* rewind_state_buffer(size_t size)
+{
+    if (!ring || !grow(&next, &next_alloc, size))
+        return NULL;
+    return next;
+}
+
+snapshot_memory_cache_t* rewind_state_cache(void)
+{
+    return next_cache;
+}
+
+void rewind_push(size_t size)
+{
+    size_t n = (size > head_size) ? size : head_size;
+    size_t length;
+    uint8_t* tmp;
+    snapshot_memory_cache_t* cache;
+
+    if (!ring || size > next_alloc)
+        return;
+
+    // Clear what is left of a larger previous state
+    if (next_used > size)
+        memset(next + size, 0, next_used - size);
+    next_used = size;
+
+    if (head_valid)
+    {
+        if (!grow(&next, &next_alloc, n)
+         || !grow(&head, &head_alloc, n)
+         || !grow(&delta, &delta_alloc, n + 2 * REWIND_MIN_SKIP))
+        {
+            rewind_reset();
+            return;
+        }
+
+        length = delta_encode(head, next, n, delta);
+        if (length > ring_size)
+            entries_count = 0;
+        else
+        {
+            struct rewind_entry* e;
+
+            if (entries_count == entries_max)
+                drop_oldest();
+            if (ring_pos + length > ring_size)
+            {
+                // Wrap around, the deltas left at the end are the oldest
+                while (entries_count && entries[entries_first].offset >= ring_pos)
+                    drop_oldest();
+                ring_pos = 0;
+            }
+            // Make room by dropping the oldest deltas overlapping the new one
+            while (entries_count)
+            {
+                e = &entries[entries_first];
+                if (e->offset >= ring_pos + length || e->offset + e->length <= ring_pos)
+                    break;
+                drop_oldest();
+            }
+
+            e = &entries[(entries_first + entries_count) % entries_max];
+            e->offset = ring_pos;
+            e->length = length;
+            e->state_size = head_size;
+            memcpy(ring + ring_pos, delta, length);
+            ring_pos += length;
+            entries_count++;
+        }
+    }
+
+    // The new state becomes the head, the old head is the next scratch buffer
+    // and still holds the state before, for the snapshot cache to reuse
+    tmp = head; head = next; next = tmp;
+    n = head_alloc; head_alloc = next_alloc; next_alloc = n;
+    cache = head_cache; head_cache = next_cache; next_cache = cache;
+    next_used = head_size;
+    head_size = size;
+    head_valid = true;
+}
+
+const uint8_t* rewind_pop(size_t* size)
+{
+    if (!head_valid)
+        return NULL;
+
+    if (entries_count)
+    {
+        struct rewind_entry* e = &entries[(entries_first + entries_count - 1) % entries_max];
+
+        delta_apply(head, ring + e->offset, e->length);
+        snapshot_memory_cache_invalidate(head_cache);
+        head_size = e->state_size;
+        ring_pos = e->offset;
+        entries_count--;
+    }
+
+    *size = head_size;
+    return head;
+}
@@ -0,0 +1,48 @@
+/* Copyright (C) 2018 
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RETRO_REWIND_H__
+#define RETRO_REWIND_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+//*****************************************************************************
+// Rewind ring storing XOR/RLE deltas between consecutive savestates.
+// Only the newest state is kept in full, every step back applies one delta.
+
+// (Re)allocate the ring, a budget of 0 frees it and disables rewinding
+void rewind_init(size_t budget, unsigned depth);
+void rewind_deinit(void);
+// Drop the recorded history
+void rewind_reset(void);
+bool rewind_enabled(void);
+
+// Buffer of at least 'size' bytes to serialize the next state into, and
+// the snapshot cache describing what the buffer still holds
+uint8_t* rewind_state_buffer(size_t size);
+snapshot_memory_cache_t* rewind_state_cache(void);
+// Record the state written to rewind_state_buffer() as the newest one
+void rewind_push(size_t size);
+// Step back one state, returns the oldest state once the history runs out
+const uint8_t* rewind_pop(size_t* size);
+
+#endif
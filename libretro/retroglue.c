@@ -169,6 +169,102 @@ void zip_uncompress(char *in, char *out, char *lastfile)
     }
 }
 
+#include "zfile.h"
+
+/* Uncompress the only disk or tape image in the ZIP `in', or `member' if
+   given, into memory.  It is opened as `out'/<name>, which goes to `image'.
+   Returns -1 for anything that has to be extracted into `out' instead. */
+int zip_uncompress_memory(char *in, char *out, char *member, char *image)
+{
+    unzFile uf = NULL;
+    uf = unzOpen(in);
+    if (uf == NULL)
+        return -1;
+
+    uLong i;
+    unz_global_info gi;
+    unz_file_info file_info;
+    int err;
+    err = unzGetGlobalInfo (uf, &gi);
+
+    char filename_inzip[256];
+    char image_inzip[256];
+    int images = 0;
+    image_inzip[0] = '\0';
+
+    for (i = 0; i < gi.number_entry && err == UNZ_OK; i++)
+    {
+        if (i > 0 && (err = unzGoToNextFile(uf)) != UNZ_OK)
+            break;
+
+        filename_inzip[0] = '\0';
+        err = unzGetCurrentFileInfo(uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0);
+        if (err != UNZ_OK)
+            break;
+
+        if (member != NULL && strcmp(filename_inzip, member))
+            continue;
+        // Subdirectories are browsed in directory mode
+        else if (strchr(filename_inzip, '/') || strchr(filename_inzip, '\\'))
+            err = UNZ_BADZIPFILE;
+        // Disk and tape images, zfile uncompresses gzipped ones from a file
+        else if ((dc_get_image_type(filename_inzip) == DC_IMAGE_TYPE_FLOPPY || dc_get_image_type(filename_inzip) == DC_IMAGE_TYPE_TAPE)
+              && !strendswith(filename_inzip, "z"))
+        {
+            images++;
+            snprintf(image_inzip, sizeof(image_inzip), "%s", filename_inzip);
+        }
+        // Memory images and NIBs need the extracted files
+        else if (member != NULL || dc_get_image_type(filename_inzip) == DC_IMAGE_TYPE_MEM || strendswith(filename_inzip, ".nib"))
+            err = UNZ_BADZIPFILE;
+    }
+
+    char *buf = NULL;
+    uLong size = 0;
+
+    if (err == UNZ_OK && images == 1)
+        err = unzLocateFile(uf, image_inzip, 1);
+    else
+        err = UNZ_BADZIPFILE;
+    if (err == UNZ_OK)
+        err = unzGetCurrentFileInfo(uf, &file_info, NULL, 0, NULL, 0, NULL, 0);
+    if (err == UNZ_OK)
+    {
+        snprintf(image, RETRO_PATH_MAX, "%s%s%s", out, FSDEV_DIR_SEP_STR, image_inzip);
+        buf = zfile_memory_add(image, file_info.uncompressed_size);
+        if (buf == NULL)
+            err = UNZ_INTERNALERROR;
+    }
+    if (err == UNZ_OK)
+        err = unzOpenCurrentFile(uf);
+    if (err == UNZ_OK)
+    {
+        while (size < file_info.uncompressed_size
+            && (err = unzReadCurrentFile(uf, buf + size, file_info.uncompressed_size - size)) > 0)
+            size += err;
+        if (err >= 0 && size == file_info.uncompressed_size)
+            err = unzCloseCurrentFile(uf);
+        else
+        {
+            fprintf(stderr, "Unzip: Error %d with zipfile in unzReadCurrentFile\n", err);
+            unzCloseCurrentFile(uf);
+            err = UNZ_BADZIPFILE;
+        }
+    }
+
+    unzClose(uf);
+
+    if (err != UNZ_OK)
+    {
+        if (buf != NULL)
+            zfile_memory_remove(image);
+        return -1;
+    }
+
+    fprintf(stdout, "Unzip memory:  %s\n", image);
+    return 0;
+}
+
 /* NIBTOOLS */
 typedef unsigned char BYTE;
 typedef unsigned char __u_char;
@@ -4,6 +4,7 @@
 #include "deps/libz/zlib.h"
 #include "deps/libz/unzip.h"
 void zip_uncompress(char *in, char *out, char *lastfile);
+int zip_uncompress_memory(char *in, char *out, char *member, char *image);
 
 int nib_convert(char *in, char *out);
 
@@ -29,12 +29,64 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "alarm.h"
 #include "lib.h"
 #include "log.h"
 #include "types.h"
 
+#ifdef ALARM_TRACE
+/* Trace of all alarm operations, written to the file named by the
+   VICE_ALARM_TRACE environment variable.  Each record is followed by the
+   name for contexts and alarms being created.  */
+typedef struct alarm_trace_record_s {
+    uint32_t op;
+    uint32_t context;
+    uint32_t alarm;
+    uint32_t clk;
+} alarm_trace_record_t;
+
+#define ALARM_TRACE_NAME_LEN 32
+
+static FILE *alarm_trace_file = NULL;
+static int alarm_trace_opened = 0;
+static unsigned int alarm_trace_contexts = 0;
+static unsigned int alarm_trace_alarms = 0;
+
+void alarm_trace(int op, unsigned int context, unsigned int alarm,
+                 CLOCK clk, const char *name)
+{
+    alarm_trace_record_t record;
+
+    if (!alarm_trace_opened) {
+        const char *path = getenv("VICE_ALARM_TRACE");
+
+        alarm_trace_opened = 1;
+        if (path != NULL) {
+            alarm_trace_file = fopen(path, "wb");
+        }
+    }
+    if (alarm_trace_file == NULL) {
+        return;
+    }
+
+    record.op = (uint32_t)op;
+    record.context = context;
+    record.alarm = alarm;
+    record.clk = clk;
+    fwrite(&record, sizeof(record), 1, alarm_trace_file);
+
+    if (op == ALARM_TRACE_CONTEXT || op == ALARM_TRACE_NEW) {
+        char buf[ALARM_TRACE_NAME_LEN];
+
+        memset(buf, 0, sizeof(buf));
+        strncpy(buf, name, sizeof(buf) - 1);
+        fwrite(buf, sizeof(buf), 1, alarm_trace_file);
+    }
+}
+#endif
+
 
 alarm_context_t *alarm_context_new(const char *name)
 {
@@ -54,6 +106,12 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = (CLOCK) ~0L;
+    context->next_pending_alarm_idx = -1;
+
+#ifdef ALARM_TRACE
+    context->trace_id = alarm_trace_contexts++;
+    alarm_trace(ALARM_TRACE_CONTEXT, context->trace_id, 0, 0, name);
+#endif
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -85,6 +143,9 @@ void alarm_context_time_warp(alarm_context_t *context, CLOCK warp_amount,
         return;
     }
 
+    ALARM_TRACE_RECORD(ALARM_TRACE_WARP, context->trace_id,
+                       (unsigned int)(warp_direction > 0), warp_amount);
+
     for (i = 0; i < context->num_pending_alarms; i++) {
         if (warp_direction > 0) {
             context->pending_alarms[i].clk += warp_amount;
@@ -112,6 +173,11 @@ static void alarm_init(alarm_t *alarm, alarm_context_t *context,
 
     alarm->pending_idx = -1;      /* Not pending.  */
 
+#ifdef ALARM_TRACE
+    alarm->trace_id = alarm_trace_alarms++;
+    alarm_trace(ALARM_TRACE_NEW, context->trace_id, alarm->trace_id, 0, name);
+#endif
+
     /* Add to the head of the alarm list of the alarm context.  */
     if (context->alarms == NULL) {
         context->alarms = alarm;
@@ -146,6 +212,8 @@ void alarm_destroy(alarm_t *alarm)
 
     alarm_unset(alarm);
 
+    ALARM_TRACE_RECORD(ALARM_TRACE_DESTROY, 0, alarm->trace_id, 0);
+
     context = alarm->context;
 
     if (alarm == context->alarms) {
@@ -164,6 +232,45 @@ void alarm_destroy(alarm_t *alarm)
     lib_free(alarm);
 }
 
+#ifdef ALARM_USE_HEAP
+
+void alarm_unset(alarm_t *alarm)
+{
+    alarm_context_t *context;
+    int idx;
+    unsigned int last;
+
+    idx = alarm->pending_idx;
+
+    if (idx < 0) {
+        return;                 /* Not pending.  */
+    }
+    context = alarm->context;
+
+    ALARM_TRACE_RECORD(ALARM_TRACE_UNSET, 0, alarm->trace_id, 0);
+
+    last = --context->num_pending_alarms;
+
+    if (last != (unsigned int)idx) {
+        /* Fill the hole with the last alarm and restore the heap order
+           around it.  */
+        CLOCK clk = context->pending_alarms[last].clk;
+
+        context->pending_alarms[idx] = context->pending_alarms[last];
+        if (idx > 0 && clk < context->pending_alarms[(idx - 1) / 2].clk) {
+            alarm_heap_sift_up(context, (unsigned int)idx);
+        } else {
+            alarm_heap_sift_down(context, (unsigned int)idx);
+        }
+    }
+
+    alarm_context_update_next_pending(context);
+
+    alarm->pending_idx = -1;
+}
+
+#else
+
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
@@ -176,6 +283,8 @@ void alarm_unset(alarm_t *alarm)
     }
     context = alarm->context;
 
+    ALARM_TRACE_RECORD(ALARM_TRACE_UNSET, 0, alarm->trace_id, 0);
+
     if (context->num_pending_alarms > 1) {
         int last;
 
@@ -206,6 +315,8 @@ void alarm_unset(alarm_t *alarm)
     alarm->pending_idx = -1;
 }
 
+#endif
+
 void alarm_log_too_many_alarms(void)
 {
     log_error(LOG_DEFAULT, "alarm_set(): Too many alarms set!");
@@ -49,6 +49,11 @@ struct alarm_s {
        pending.  */
     int pending_idx;
 
+#ifdef ALARM_TRACE
+    /* Number of the alarm in the trace.  */
+    unsigned int trace_id;
+#endif
+
     /* Call data */
     void *data;
 
@@ -75,7 +80,8 @@ struct alarm_context_s {
     struct alarm_s *alarms;
 
     /* Pending alarm array.  Statically allocated because it's slightly
-       faster this way.  */
+       faster this way.  With ALARM_USE_HEAP it is kept as a binary heap
+       ordered by clock, so the next alarm is always the first one.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
@@ -84,6 +90,11 @@ struct alarm_context_s {
 
     /* Pending alarm number.  */
     int next_pending_alarm_idx;
+
+#ifdef ALARM_TRACE
+    /* Number of the context in the trace.  */
+    unsigned int trace_id;
+#endif
 };
 typedef struct alarm_context_s alarm_context_t;
 
@@ -100,6 +111,26 @@ extern void alarm_destroy(alarm_t *alarm);
 extern void alarm_unset(alarm_t *alarm);
 extern void alarm_log_too_many_alarms(void);
 
+/* Alarm trace records, replayed by benchmark/alarm_replay.  */
+enum alarm_trace_op_e {
+    ALARM_TRACE_CONTEXT,    /* context, name */
+    ALARM_TRACE_NEW,        /* context, alarm, name */
+    ALARM_TRACE_DESTROY,    /* alarm */
+    ALARM_TRACE_SET,        /* alarm, clk */
+    ALARM_TRACE_UNSET,      /* alarm */
+    ALARM_TRACE_DISPATCH,   /* context, alarm dispatched, clk */
+    ALARM_TRACE_WARP        /* context, amount, direction in alarm */
+};
+
+#ifdef ALARM_TRACE
+extern void alarm_trace(int op, unsigned int context, unsigned int alarm,
+                        CLOCK clk, const char *name);
+#define ALARM_TRACE_RECORD(op, context, alarm, clk) \
+    alarm_trace(op, context, alarm, clk, NULL)
+#else
+#define ALARM_TRACE_RECORD(op, context, alarm, clk)
+#endif
+
 /* ------------------------------------------------------------------------- */
 
 /* Inline functions.  */
@@ -109,6 +140,76 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
     return context->next_pending_alarm_clk;
 }
 
+#ifdef ALARM_USE_HEAP
+
+/* Move the pending alarm at `idx' up the heap while it is due before its
+   parent.  */
+inline static void alarm_heap_sift_up(alarm_context_t *context,
+                                      unsigned int idx)
+{
+    pending_alarms_t *heap = context->pending_alarms;
+    alarm_t *alarm = heap[idx].alarm;
+    CLOCK clk = heap[idx].clk;
+
+    while (idx > 0) {
+        unsigned int parent = (idx - 1) / 2;
+
+        if (heap[parent].clk <= clk) {
+            break;
+        }
+        heap[idx] = heap[parent];
+        heap[idx].alarm->pending_idx = (int)idx;
+        idx = parent;
+    }
+    heap[idx].alarm = alarm;
+    heap[idx].clk = clk;
+    alarm->pending_idx = (int)idx;
+}
+
+/* Move the pending alarm at `idx' down the heap while one of its children
+   is due before it.  */
+inline static void alarm_heap_sift_down(alarm_context_t *context,
+                                        unsigned int idx)
+{
+    pending_alarms_t *heap = context->pending_alarms;
+    unsigned int num = context->num_pending_alarms;
+    alarm_t *alarm = heap[idx].alarm;
+    CLOCK clk = heap[idx].clk;
+
+    for (;;) {
+        unsigned int child = idx * 2 + 1;
+
+        if (child >= num) {
+            break;
+        }
+        if (child + 1 < num && heap[child + 1].clk < heap[child].clk) {
+            child++;
+        }
+        if (clk <= heap[child].clk) {
+            break;
+        }
+        heap[idx] = heap[child];
+        heap[idx].alarm->pending_idx = (int)idx;
+        idx = child;
+    }
+    heap[idx].alarm = alarm;
+    heap[idx].clk = clk;
+    alarm->pending_idx = (int)idx;
+}
+
+inline static void alarm_context_update_next_pending(alarm_context_t *context)
+{
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm_idx = 0;
+    } else {
+        context->next_pending_alarm_clk = (CLOCK)~0L;
+        context->next_pending_alarm_idx = -1;
+    }
+}
+
+#else
+
 inline static void alarm_context_update_next_pending(alarm_context_t *context)
 {
     CLOCK next_pending_alarm_clk = (CLOCK)~0L;
@@ -130,6 +231,8 @@ inline static void alarm_context_update_next_pending(alarm_context_t *context)
     context->next_pending_alarm_idx = next_pending_alarm_idx;
 }
 
+#endif
+
 inline static void alarm_context_dispatch(alarm_context_t *context,
                                           CLOCK cpu_clk)
 {
@@ -142,9 +245,14 @@ inline static void alarm_context_dispatch(alarm_context_t *context,
     idx = context->next_pending_alarm_idx;
     alarm = context->pending_alarms[idx].alarm;
 
+    ALARM_TRACE_RECORD(ALARM_TRACE_DISPATCH, context->trace_id,
+                       alarm->trace_id, cpu_clk);
+
     (alarm->callback)(offset, alarm->data);
 }
 
+#ifdef ALARM_USE_HEAP
+
 inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
 {
     alarm_context_t *context;
@@ -153,6 +261,52 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
     context = alarm->context;
     idx = alarm->pending_idx;
 
+    ALARM_TRACE_RECORD(ALARM_TRACE_SET, 0, alarm->trace_id, cpu_clk);
+
+    if (idx < 0) {
+        /* Not pending yet: add.  */
+
+        idx = (int)(context->num_pending_alarms);
+        if (idx >= (int)ALARM_CONTEXT_MAX_PENDING_ALARMS) {
+            alarm_log_too_many_alarms();
+            return;
+        }
+
+        context->pending_alarms[idx].alarm = alarm;
+        context->pending_alarms[idx].clk = cpu_clk;
+
+        context->num_pending_alarms++;
+
+        alarm_heap_sift_up(context, (unsigned int)idx);
+    } else {
+        /* Already pending: modify.  */
+
+        CLOCK old_clk = context->pending_alarms[idx].clk;
+
+        context->pending_alarms[idx].clk = cpu_clk;
+        if (cpu_clk < old_clk) {
+            alarm_heap_sift_up(context, (unsigned int)idx);
+        } else {
+            alarm_heap_sift_down(context, (unsigned int)idx);
+        }
+    }
+
+    context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+    context->next_pending_alarm_idx = 0;
+}
+
+#else
+
+inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
+{
+    alarm_context_t *context;
+    int idx;
+
+    context = alarm->context;
+    idx = alarm->pending_idx;
+
+    ALARM_TRACE_RECORD(ALARM_TRACE_SET, 0, alarm->trace_id, cpu_clk);
+
     if (idx < 0) {
         int new_idx;
 
@@ -187,3 +341,5 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
 }
 
 #endif
+
+#endif
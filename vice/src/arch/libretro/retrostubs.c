@@ -54,11 +54,12 @@ char core_old_key_state[512];
 bool num_locked = false;
 unsigned int statusbar;
 unsigned int warpmode;
+unsigned int rewindmode;
 unsigned int datasette_hotkeys;
 unsigned int cur_port=2;
 static int cur_port_prev=-1;
 extern int cur_port_locked;
-extern int mapper_keys[36];
+extern int mapper_keys[37];
 extern unsigned int opt_retropad_options;
 extern unsigned int opt_joyport_type;
 static int opt_joyport_type_prev = -1;
@@ -89,6 +90,7 @@ enum EMU_FUNCTIONS
     EMU_RESET,
     EMU_ZOOM_MODE,
     EMU_WARP,
+    EMU_REWIND,
     EMU_DATASETTE_HOTKEYS,
     EMU_DATASETTE_STOP,
     EMU_DATASETTE_START,
@@ -146,6 +148,9 @@ void emu_function(int function)
             warpmode = (warpmode) ? 0 : 1;
             resources_set_int("WarpMode", warpmode);
             break;
+        case EMU_REWIND:
+            rewindmode = (rewindmode) ? 0 : 1;
+            break;
         case EMU_DATASETTE_HOTKEYS:
             datasette_hotkeys = (datasette_hotkeys) ? 0 : 1;
             break;
@@ -342,22 +347,25 @@ void update_input(int disable_physical_cursor_keys)
                     emu_function(EMU_WARP);
                     break;
                 case 30:
+                    emu_function(EMU_REWIND);
+                    break;
+                case 31:
                     emu_function(EMU_DATASETTE_HOTKEYS);
                     break;
 
-                case 31:
+                case 32:
                     emu_function(EMU_DATASETTE_STOP);
                     break;
-                case 32:
+                case 33:
                     emu_function(EMU_DATASETTE_START);
                     break;
-                case 33:
+                case 34:
                     emu_function(EMU_DATASETTE_FORWARD);
                     break;
-                case 34:
+                case 35:
                     emu_function(EMU_DATASETTE_REWIND);
                     break;
-                case 35:
+                case 36:
                     emu_function(EMU_DATASETTE_RESET);
                     break;
             }
@@ -371,6 +379,9 @@ void update_input(int disable_physical_cursor_keys)
                 case 29:
                     emu_function(EMU_WARP);
                     break;
+                case 30:
+                    emu_function(EMU_REWIND);
+                    break;
             }
         }
     }
@@ -478,17 +489,19 @@ void update_input(int disable_physical_cursor_keys)
                         emu_function(EMU_ZOOM_MODE);
                     else if (mapper_keys[i] == mapper_keys[29]) /* Hold warp mode */
                         emu_function(EMU_WARP);
-                    else if (mapper_keys[i] == mapper_keys[30]) /* Datasette hotkeys toggle */
+                    else if (mapper_keys[i] == mapper_keys[30]) /* Hold rewind */
+                        emu_function(EMU_REWIND);
+                    else if (mapper_keys[i] == mapper_keys[31]) /* Datasette hotkeys toggle */
                         emu_function(EMU_DATASETTE_HOTKEYS);
-                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[31]) /* Datasette stop */
+                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[32]) /* Datasette stop */
                         emu_function(EMU_DATASETTE_STOP);
-                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[32]) /* Datasette start */
+                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[33]) /* Datasette start */
                         emu_function(EMU_DATASETTE_START);
-                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[33]) /* Datasette forward */
+                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[34]) /* Datasette forward */
                         emu_function(EMU_DATASETTE_FORWARD);
-                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[34]) /* Datasette rewind */
+                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[35]) /* Datasette rewind */
                         emu_function(EMU_DATASETTE_REWIND);
-                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[35]) /* Datasette reset */
+                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[36]) /* Datasette reset */
                         emu_function(EMU_DATASETTE_RESET);
                     else if (mapper_keys[i] == -5) /* Mouse speed slower */
                         mouse_speed[j] |= MOUSE_SPEED_SLOWER;
@@ -522,8 +535,8 @@ void update_input(int disable_physical_cursor_keys)
                     else if (mapper_keys[i] == mapper_keys[29])
                         emu_function(EMU_WARP);
                     else if (mapper_keys[i] == mapper_keys[30])
-                        ; /* nop */
-                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[31])
+                        emu_function(EMU_REWIND);
+                    else if (mapper_keys[i] == mapper_keys[31])
                         ; /* nop */
                     else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[32])
                         ; /* nop */
@@ -533,6 +546,8 @@ void update_input(int disable_physical_cursor_keys)
                         ; /* nop */
                     else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[35])
                         ; /* nop */
+                    else if (datasette_hotkeys && mapper_keys[i] == mapper_keys[36])
+                        ; /* nop */
                     else if (mapper_keys[i] == -5) /* Mouse speed slower */
                         mouse_speed[j] &= ~MOUSE_SPEED_SLOWER;
                     else if (mapper_keys[i] == -6) /* Mouse speed faster */
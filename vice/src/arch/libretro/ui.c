@@ -67,6 +67,7 @@ BYTE c64memrom_kernal64_rom_original[C64_KERNAL_ROM_SIZE] = {0};
 
 int RETROTDE=0;
 int RETRODSE=0;
+int RETRODRIVEIDLESKIP=1;
 int RETRORESET=0;
 int RETROSIDENGINE=0;
 int RETROSIDMODL=0;
@@ -275,6 +276,8 @@ int ui_init_finalize(void)
       log_resources_set_int("DriveSoundEmulationVolume", RETRODSE);
    }
 
+   log_resources_set_int("Drive8IdleLoopSkip", RETRODRIVEIDLESKIP);
+
    log_resources_set_int("AutostartWarp", RETROAUTOSTARTWARP);
 
 #if defined(__X64__) || defined(__X64SC__) || defined(__X128__)
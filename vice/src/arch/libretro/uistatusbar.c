@@ -355,6 +355,8 @@ void ui_display_drive_current_image(unsigned int drive_number, const char *image
 #ifdef SDL_DEBUG
     fprintf(stderr, "%s\n", __func__);
 #endif
+    /* Attached disks are part of the savestate */
+    snapshot_size_invalidate();
 }
 
 /* Tape related UI */
@@ -418,6 +420,7 @@ void ui_display_tape_current_image(const char *image)
 #ifdef SDL_DEBUG
     fprintf(stderr, "%s: %s\n", __func__, image);
 #endif
+    snapshot_size_invalidate();
 }
 
 /* Recording UI */
@@ -24,6 +24,11 @@
 
 struct video_canvas_s *RCANVAS;
 
+/* Draw buffer lines refreshed by the raster since they were last rendered,
+   empty when retro_dirty_ye <= retro_dirty_ys */
+unsigned int retro_dirty_ys = 0;
+unsigned int retro_dirty_ye = 0;
+
 int machine_ui_done = 0;
 static int drive_led_on = 0, tape_led_on = 0;
 
@@ -45,6 +50,25 @@ void video_canvas_resize(struct video_canvas_s *canvas,  char resizecv)
 {
 }
 
+/* All canvases of the machine, the C128 has one for the VIC-II and one
+   for the VDC */
+#define RETRO_CANVAS_MAX 4
+static struct video_canvas_s *retro_canvas[RETRO_CANVAS_MAX];
+static unsigned int retro_canvas_count = 0;
+
+/* Frames that are not shown are emulated without drawing their lines.
+   This is decided by the core before each frame, vsync_do_vsync() only
+   ever asks for the frame to be drawn.  */
+void retro_skip_frame(int skip)
+{
+   /* The canvas shown is the one refreshed last, skipping frames would
+      change which of the VIC-II and the VDC that is */
+   if (retro_canvas_count != 1 || !retro_canvas[0]->parent_raster)
+      return;
+
+   raster_skip_frame(retro_canvas[0]->parent_raster, skip);
+}
+
 static video_canvas_t *retro_canvas_create(video_canvas_t *canvas, unsigned int *width, unsigned int *height)
 {
    return canvas;
@@ -56,11 +80,21 @@ video_canvas_t *video_canvas_create(video_canvas_t *canvas,
    canvas->videoconfig->rendermode = VIDEO_RENDER_RGB_1X1;
    canvas->depth = 8*pix_bytes;
    video_canvas_set_palette(canvas, canvas->palette);
+   if (retro_canvas_count < RETRO_CANVAS_MAX)
+      retro_canvas[retro_canvas_count++] = canvas;
    return canvas;
 }
 
 void video_canvas_destroy(struct video_canvas_s *canvas)
 {
+   unsigned int i;
+
+   for (i = 0; i < retro_canvas_count; i++) {
+      if (retro_canvas[i] == canvas) {
+         retro_canvas[i] = retro_canvas[--retro_canvas_count];
+         break;
+      }
+   }
 }
 
 static int video_frame_buffer_alloc(video_canvas_t *canvas, 
@@ -137,6 +171,9 @@ int video_canvas_set_palette(struct video_canvas_s *canvas,
    }
    video_render_initraw(canvas->videoconfig);
 
+   /* Lines rendered with the old colours are outdated */
+   retro_render_full = 1;
+
    return 0;
 }
 
@@ -149,6 +186,16 @@ void video_canvas_refresh(struct video_canvas_s *canvas,
    printf("XS:%d YS:%d XI:%d YI:%d W:%d H:%d\n",xs,ys,xi,yi,w,h);
 #endif
    RCANVAS=canvas;
+
+   if (retro_dirty_ye <= retro_dirty_ys) {
+      retro_dirty_ys = ys;
+      retro_dirty_ye = ys + h;
+   } else {
+      if (ys < retro_dirty_ys)
+         retro_dirty_ys = ys;
+      if (ys + h > retro_dirty_ye)
+         retro_dirty_ye = ys + h;
+   }
 }
 
 int video_init()
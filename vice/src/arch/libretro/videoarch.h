@@ -22,6 +22,7 @@ struct video_canvas_s {
     unsigned int depth;
 
     struct video_draw_buffer_callback_s *video_draw_buffer_callback;
+    struct raster_s *parent_raster;
 };
 typedef struct video_canvas_s video_canvas_t;
 
@@ -34,14 +34,22 @@
 #include "videoarch.h"
 #include "video.h"
 #include "resources.h"
+#include "raster.h"
+#include "raster-canvas.h"
 
 #include "libretro-core.h"
+#include "retro_perf.h"
+#if defined(__X128__)
+#include "vdc.h"
+#endif
 
 #if defined(VITA)
 #include <psp2/kernel/threadmgr.h>
 #endif
 
 extern struct video_canvas_s *RCANVAS;
+extern unsigned int retro_dirty_ys;
+extern unsigned int retro_dirty_ye;
 
 #include <time.h>
 
@@ -96,20 +104,110 @@ void vsyncarch_sleep(unsigned long delay)
     // of the frontend.
 }
 
-void vsyncarch_presync(void)
+/* Canvas and layout of retro_bmp as last rendered */
+static struct video_canvas_s *last_canvas = NULL;
+static int last_geometry[4];
+
+static int render_layout_changed(void)
 {
-    kbdbuf_flush();
+    int geometry[4] = { retroW, retroH, retroXS, retroYS };
+
+    return RCANVAS != last_canvas || memcmp(geometry, last_geometry, sizeof(geometry));
+}
+
+/* Convert the draw buffer lines changed since the last render into
+   retro_bmp, or all of them when the layout or the colours changed */
+static void render_canvas(void)
+{
+    int geometry[4] = { retroW, retroH, retroXS, retroYS };
+    int ys = retroYS, ye = retroYS + retroH;
+
+    if (render_layout_changed()) {
+        last_canvas = RCANVAS;
+        memcpy(last_geometry, geometry, sizeof(geometry));
+        retro_render_full = 1;
+    }
+    /* The palette is updated on demand by the render itself */
+    if (!RCANVAS->videoconfig->color_tables.updated) {
+        retro_render_full = 1;
+    }
+    /* Lines drawn by a raster whose frame does not end with ours, such as
+       the VDC, are only refreshed later but already show in the buffer */
+    if (RCANVAS->parent_raster && !RCANVAS->parent_raster->update_area->is_null) {
+        raster_canvas_area_t *area = RCANVAS->parent_raster->update_area;
+        /* One more line on both sides for the CRT emulation */
+        unsigned int area_ys = area->ys ? area->ys - 1 : 0;
+        unsigned int area_ye = area->ye + 2;
+
+        if (retro_dirty_ye <= retro_dirty_ys) {
+            retro_dirty_ys = area_ys;
+            retro_dirty_ye = area_ye;
+        } else {
+            if (area_ys < retro_dirty_ys) {
+                retro_dirty_ys = area_ys;
+            }
+            if (area_ye > retro_dirty_ye) {
+                retro_dirty_ye = area_ye;
+            }
+        }
+    }
+
+    if (!retro_render_full) {
+        if ((int)retro_dirty_ys > ys) {
+            ys = retro_dirty_ys;
+        }
+        if ((int)retro_dirty_ye < ye) {
+            ye = retro_dirty_ye;
+        }
+    }
+    retro_render_full = 0;
+    retro_dirty_ys = retro_dirty_ye = 0;
+
+    if (ye <= ys) {
+        return;
+    }
 
     video_canvas_render(
         RCANVAS, (BYTE *)&retro_bmp,
-        retroW, retroH,
-        retroXS, retroYS,
-        0, 0, //xi, yi,
+        retroW, ye - ys,
+        retroXS, ys,
+        0, ys - retroYS, //xi, yi,
         retroW*pix_bytes, 8*pix_bytes
     );
-                        
-    if (uistatusbar_state & UISTATUSBAR_ACTIVE) {
-        uistatusbar_draw();
+    retro_frame_changed = 1;
+}
+
+void vsyncarch_presync(void)
+{
+    static int statusbar_drawn = 0;
+
+    kbdbuf_flush();
+
+#if defined(__X128__)
+    /* The VDC canvas may be the one rendered */
+    vdc_finish_drawing();
+#endif
+
+    /* This frame is not shown, leave the screen as it is unless retro_bmp
+       no longer matches the geometry the frontend is given */
+    if (RCANVAS && (retro_draw_frame || render_layout_changed())) {
+        /* The statusbar is drawn over retro_bmp, so it has to be redrawn
+           from scratch while it is shown and once it goes away */
+        if (statusbar_drawn) {
+            retro_render_full = 1;
+        }
+
+        RETRO_PERF_BEGIN(RETRO_PERF_RENDER);
+        render_canvas();
+        RETRO_PERF_END(RETRO_PERF_RENDER);
+
+        statusbar_drawn = uistatusbar_state & UISTATUSBAR_ACTIVE;
+        if (statusbar_drawn) {
+            RETRO_PERF_BEGIN(RETRO_PERF_STATUSBAR);
+            uistatusbar_draw();
+            RETRO_PERF_END(RETRO_PERF_STATUSBAR);
+            retro_frame_changed = 1;
+        }
     }
 
     cpuloop=0;
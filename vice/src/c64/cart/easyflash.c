@@ -578,8 +578,8 @@ int easyflash_snapshot_write_module(snapshot_t *s)
         || (SMW_B(m, easyflash_register_00) < 0)
         || (SMW_B(m, easyflash_register_02) < 0)
         || (SMW_BA(m, easyflash_ram, 256) < 0)
-        || (SMW_BA(m, roml_banks, 0x80000) < 0)
-        || (SMW_BA(m, romh_banks, 0x80000) < 0)) {
+        || (SMW_BA_GEN(m, roml_banks, 0x80000, easyflash_state_low->generation) < 0)
+        || (SMW_BA_GEN(m, romh_banks, 0x80000, easyflash_state_high->generation) < 0)) {
         snapshot_module_close(m);
         return -1;
     }
@@ -110,6 +110,10 @@ static uint8_t georam[2];
 static uint8_t *georam_ram = NULL;
 static int old_georam_ram_size = 0;
 
+/* Incremented whenever the contents of georam_ram change, so that snapshots
+   can leave the RAM in place while it is untouched.  */
+static unsigned int georam_ram_generation = 0;
+
 static log_t georam_log = LOG_ERR;
 
 static int georam_activate(void);
@@ -197,6 +201,7 @@ static uint8_t georam_io1_read(uint16_t addr)
 static void georam_io1_store(uint16_t addr, uint8_t byte)
 {
     georam_ram[(georam[1] * 16384) + (georam[0] * 256) + addr] = byte;
+    georam_ram_generation++;
 }
 
 static uint8_t georam_io2_peek(uint16_t addr)
@@ -238,6 +243,7 @@ static int georam_activate(void)
     }
 
     georam_ram = lib_realloc((void *)georam_ram, (size_t)georam_size);
+    georam_ram_generation++;
 
     /* Clear newly allocated RAM.  */
     if (georam_size > old_georam_ram_size) {
@@ -543,6 +549,7 @@ void georam_config_setup(uint8_t *rawcart)
 {
     if (georam_size > 0) {
         memcpy(georam_ram, rawcart, georam_size);
+        georam_ram_generation++;
     }
 }
 
@@ -625,7 +632,7 @@ int georam_write_snapshot_module(snapshot_t *s)
         || SMW_B(m, (uint8_t)georam_io_swap) < 0
         || SMW_DW(m, (georam_size >> 10)) < 0
         || SMW_BA(m, georam, sizeof(georam)) < 0
-        || SMW_BA(m, georam_ram, georam_size) < 0) {
+        || SMW_BA_GEN(m, georam_ram, georam_size, georam_ram_generation) < 0) {
         snapshot_module_close(m);
         return -1;
     }
@@ -676,6 +683,7 @@ int georam_read_snapshot_module(snapshot_t *s)
         set_georam_enabled(1, NULL);
     }
 
+    georam_ram_generation++;
     if (SMR_BA(m, georam, sizeof(georam)) < 0 || SMR_BA(m, georam_ram, georam_size) < 0) {
         goto fail;
     }
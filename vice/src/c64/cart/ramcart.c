@@ -109,6 +109,10 @@ static uint8_t ramcart[2];
 static uint8_t *ramcart_ram = NULL;
 static int old_ramcart_ram_size = 0;
 
+/* Incremented whenever the contents of ramcart_ram change, so that snapshots
+   can leave the RAM in place while it is untouched.  */
+static unsigned int ramcart_ram_generation = 0;
+
 static log_t ramcart_log = LOG_ERR;
 
 static int ramcart_activate(void);
@@ -249,6 +253,7 @@ static uint8_t ramcart_io2_read(uint16_t addr)
 static void ramcart_io2_store(uint16_t addr, uint8_t byte)
 {
     ramcart_ram[((ramcart[1] & 1) * 65536) + (ramcart[0] * 256) + (addr & 0xff)] = byte;
+    ramcart_ram_generation++;
 }
 
 static int ramcart_dump(void)
@@ -280,6 +285,7 @@ static int ramcart_activate(void)
     }
 
     ramcart_ram = lib_realloc((void *)ramcart_ram, (size_t)ramcart_size);
+    ramcart_ram_generation++;
 
     /* Clear newly allocated RAM.  */
     if (ramcart_size > old_ramcart_ram_size) {
@@ -561,6 +567,7 @@ void ramcart_reset(void)
 void ramcart_config_setup(uint8_t *rawcart)
 {
     memcpy(ramcart_ram, rawcart, ramcart_size);
+    ramcart_ram_generation++;
 }
 
 void ramcart_detach(void)
@@ -686,7 +693,7 @@ int ramcart_snapshot_write_module(snapshot_t *s)
         || (SMW_DW(m, (uint32_t)ramcart_size) < 0)
         || (SMW_B(m, (uint8_t)ramcart_size_kb) < 0)
         || (SMW_BA(m, ramcart, 2) < 0)
-        || (SMW_BA(m, ramcart_ram, ramcart_size) < 0)) {
+        || (SMW_BA_GEN(m, ramcart_ram, ramcart_size, ramcart_ram_generation) < 0)) {
         snapshot_module_close(m);
         return -1;
     }
@@ -721,6 +728,7 @@ int ramcart_snapshot_read_module(snapshot_t *s)
     }
 
     ramcart_ram = lib_malloc(ramcart_size);
+    ramcart_ram_generation++;
 
     if (SMR_BA(m, ramcart_ram, ramcart_size) < 0) {
         snapshot_module_close(m);
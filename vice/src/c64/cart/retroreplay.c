@@ -1286,7 +1286,7 @@ int retroreplay_snapshot_write_module(snapshot_t *s)
         || SMW_B(m, (uint8_t)rr_hw_flashjumper) < 0
         || SMW_B(m, (uint8_t)rr_hw_bankjumper) < 0
         || SMW_DW(m, (uint32_t)rom_offset) < 0
-        || SMW_BA(m, roml_banks, 0x20000) < 0
+        || SMW_BA_GEN(m, roml_banks, 0x20000, flashrom_state->generation) < 0
         || SMW_BA(m, export_ram0, 0x8000) < 0) {
         snapshot_module_close(m);
         return -1;
@@ -229,6 +229,9 @@ static uint8_t *reu_ram = NULL;
 /*! \brief the old ram size of reu_ram. Used to determine if and how much of the
     buffer has to cleared when resizing the REU. */
 static unsigned int old_reu_ram_size = 0;
+/*! \brief incremented whenever the contents of reu_ram change, so that
+    snapshots can leave the RAM of an idle REU in place. */
+static unsigned int reu_ram_generation = 0;
 
 static log_t reu_log = LOG_ERR; /*!< the log output for the REU */
 
@@ -574,6 +577,7 @@ void reu_config_setup(uint8_t *rawcart)
 {
     if (reu_size > 0) {
         memcpy(reu_ram, rawcart, reu_size); /* FIXME */
+        reu_ram_generation++;
     }
 }
 
@@ -614,6 +618,7 @@ static int reu_activate(void)
     }
 
     reu_ram = lib_realloc(reu_ram, reu_size);
+    reu_ram_generation++;
 
     /* Clear newly allocated RAM.  */
     if (reu_size > old_reu_ram_size) {
@@ -1038,6 +1043,7 @@ inline static void store_to_reu(unsigned int reu_addr, uint8_t value)
     if (reu_addr < rec_options.not_backedup_addresses) {
         assert(reu_addr < reu_size);
         reu_ram[reu_addr] = value;
+        reu_ram_generation++;
     } else {
         DEBUG_LOG(DEBUG_LEVEL_NO_DRAM, (reu_log, "--> writing to REU address %05X, but no DRAM!", reu_addr));
     }
@@ -1521,7 +1527,7 @@ int reu_write_snapshot_module(snapshot_t *s)
     if (0
         || SMW_DW(m, (reu_size >> 10)) < 0
         || SMW_BA(m, reu, sizeof(reu)) < 0
-        || SMW_BA(m, reu_ram, reu_size) < 0) {
+        || SMW_BA_GEN(m, reu_ram, reu_size, reu_ram_generation) < 0) {
         snapshot_module_close(m);
         return -1;
     }
@@ -1574,6 +1580,7 @@ int reu_read_snapshot_module(snapshot_t *s)
         set_reu_enabled(1, NULL);
     }
 
+    reu_ram_generation++;
     if (SMR_BA(m, reu, sizeof(reu)) < 0 || SMR_BA(m, reu_ram, reu_size) < 0) {
         goto fail;
     }
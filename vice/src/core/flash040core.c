@@ -48,6 +48,10 @@
 #define FLASH_DEBUG(x)
 #endif
 
+/* Shared by all contexts, so that a context set up again on the same data
+   never gets the generation of an earlier one.  */
+static unsigned int flash_generation = 0;
+
 struct flash_types_s {
     uint8_t manufacturer_ID;
     uint8_t device_ID;
@@ -159,6 +163,7 @@ inline static void flash_erase_sector(flash040_context_t *flash040_context, unsi
     FLASH_DEBUG(("Erasing 0x%x - 0x%x", sector_addr, sector_addr + sector_size - 1));
     memset(&(flash040_context->flash_data[sector_addr]), 0xff, sector_size);
     flash040_context->flash_dirty = 1;
+    flash040_context->generation = ++flash_generation;
 }
 
 inline static void flash_erase_chip(flash040_context_t *flash040_context)
@@ -166,6 +171,7 @@ inline static void flash_erase_chip(flash040_context_t *flash040_context)
     FLASH_DEBUG(("Erasing chip"));
     memset(flash040_context->flash_data, 0xff, flash_types[flash040_context->flash_type].size);
     flash040_context->flash_dirty = 1;
+    flash040_context->generation = ++flash_generation;
 }
 
 inline static int flash_program_byte(flash040_context_t *flash040_context, unsigned int addr, uint8_t byte)
@@ -177,6 +183,7 @@ inline static int flash_program_byte(flash040_context_t *flash040_context, unsig
     flash040_context->program_byte = byte;
     flash040_context->flash_data[addr] = new_data;
     flash040_context->flash_dirty = 1;
+    flash040_context->generation = ++flash_generation;
 
     return (new_data == byte) ? 1 : 0;
 }
@@ -488,6 +495,7 @@ void flash040core_init(struct flash040_context_s *flash040_context,
     flash040_context->program_byte = 0;
     flash_clear_erase_mask(flash040_context);
     flash040_context->flash_dirty = 0;
+    flash040_context->generation = ++flash_generation;
     flash040_context->erase_alarm = alarm_new(alarm_context, "Flash040Alarm", erase_alarm_handler, flash040_context);
 }
 
@@ -107,6 +107,7 @@ extern void disk_image_resources_shutdown(void);
 extern void disk_image_fsimage_name_set(disk_image_t *image, const char *name);
 extern const char *disk_image_fsimage_name_get(const disk_image_t *image);
 extern void *disk_image_fsimage_fd_get(const disk_image_t *image);
+extern uint32_t disk_image_attach_crc(const disk_image_t *image);
 extern int disk_image_fsimage_create(const char *name, unsigned int type);
 
 extern void disk_image_rawimage_name_set(disk_image_t *image, const char *name);
@@ -128,6 +129,7 @@ extern int disk_image_read_sector(const disk_image_t *image, uint8_t *buf,
                                   const disk_addr_t *dadr);
 extern int disk_image_write_sector(disk_image_t *image, const uint8_t *buf,
                                    const disk_addr_t *dadr);
+extern int disk_image_flush(disk_image_t *image);
 extern int disk_image_check_sector(const disk_image_t *image, unsigned int track,
                                    unsigned int sector);
 extern unsigned int disk_image_sector_per_track(unsigned int format,
@@ -137,6 +139,8 @@ extern unsigned int disk_image_raw_track_size(unsigned int format,
 extern unsigned int disk_image_gap_size(unsigned int format, unsigned int track);
 extern int disk_image_read_image(const disk_image_t *image);
 extern int disk_image_write_p64_image(const disk_image_t *image);
+extern int disk_image_read_half_track(const disk_image_t *image, unsigned int half_track,
+                                      struct disk_track_s *raw);
 extern int disk_image_write_half_track(disk_image_t *image, unsigned int half_track,
                                        const struct disk_track_s *raw);
 
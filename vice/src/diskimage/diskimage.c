@@ -412,6 +412,20 @@ void *disk_image_fsimage_fd_get(const disk_image_t *image)
     return fsimage_fd_get(image);
 }
 
+/** \brief  Get CRC32 of the sectors of a D64/D71 image at attach
+ *
+ * \param[in]   image   disk image
+ *
+ * \return  CRC32, 0 for other images
+ */
+uint32_t disk_image_attach_crc(const disk_image_t *image)
+{
+    if (image->device != DISK_IMAGE_DEVICE_FS || image->media.fsimage == NULL) {
+        return 0;
+    }
+    return image->media.fsimage->header.crc;
+}
+
 
 int disk_image_fsimage_create(const char *name, unsigned int type)
 {
@@ -643,8 +657,38 @@ int disk_image_write_sector(disk_image_t *image, const uint8_t *buf, const disk_
     return rc;
 }
 
+/* Write back sectors that are only in memory yet */
+int disk_image_flush(disk_image_t *image)
+{
+    if (image == NULL) {
+        return 0;
+    }
+
+    switch (image->device) {
+        case DISK_IMAGE_DEVICE_FS:
+            return fsimage_flush(image);
+        default:
+            return 0;
+    }
+}
+
 /*-----------------------------------------------------------------------*/
 
+int disk_image_read_half_track(const disk_image_t *image, unsigned int half_track,
+                               struct disk_track_s *raw)
+{
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_X64:
+            return fsimage_dxx_read_half_track(image, half_track, raw);
+        default:
+            /* The other images are read whole by disk_image_read_image() */
+            return 0;
+    }
+}
+
 int disk_image_write_half_track(disk_image_t *image, unsigned int half_track,
                                 const struct disk_track_s *raw)
 {
@@ -32,6 +32,7 @@
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "cbmdos.h"
+#include "crc32.h"
 #include "fsimage-dxx.h"
 #include "fsimage.h"
 #include "gcr.h"
@@ -112,6 +113,7 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
         lib_free(buffer);
         return -1;
     }
+    fsimage_cache_update(fsimage, buffer, sectors, max_sector);
     lib_free(buffer);
     if (fsimage->error_info.map) {
         if (fsimage->error_info.dirty) {
@@ -142,20 +144,102 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
     return 0;
 }
 
-int fsimage_read_dxx_image(const disk_image_t *image)
+/* Read a sector through the sector cache */
+static int fsimage_dxx_read_block(fsimage_t *fsimage, uint8_t *buf, int sectors, long base)
 {
-    uint8_t buffer[256], *bam_id;
+    if (fsimage_cache_read(fsimage, buf, sectors, base) < 0) {
+        return util_fpread(fsimage->fd, buf, 256, base + sectors * 256);
+    }
+    return 0;
+}
+
+/* Convert track `half_track / 2' of the image to GCR.  The drive does this
+   when the head first reaches the track, see drive_gcr_data_load().  */
+int fsimage_dxx_read_half_track(const disk_image_t *image, unsigned int half_track,
+                                disk_track_t *raw)
+{
+    uint8_t buffer[256];
     int gap;
     unsigned int track, sector, track_size;
     gcr_header_t header;
     fdc_err_t rf;
-    int double_sided = 0;
     fsimage_t *fsimage = image->media.fsimage;
     unsigned int max_sector;
     uint8_t *ptr;
-    int half_track;
     int sectors;
-    long offset;
+    long base;
+
+    gcr_invalidate_track(raw);
+
+    /* Odd tracks are empty */
+    if (half_track & 1) {
+        lib_free(raw->data);
+        raw->data = NULL;
+        raw->size = 0;
+        return 0;
+    }
+
+    track = half_track / 2;
+    track_size = disk_image_raw_track_size(image->type, track);
+    if (raw->data == NULL) {
+        raw->data = lib_malloc(track_size);
+    } else if (raw->size != (int)track_size) {
+        raw->data = lib_realloc(raw->data, track_size);
+    }
+    raw->size = track_size;
+    ptr = raw->data;
+
+    /* Clear track to avoid read errors.  */
+    memset(ptr, 0x55, track_size);
+
+    if (track > image->tracks) {
+        return 0;
+    }
+
+    base = (image->type == DISK_IMAGE_TYPE_X64) ? X64_HEADER_LENGTH : 0;
+
+    header.id1 = fsimage->header.id[0];
+    header.id2 = fsimage->header.id[1];
+    header.track = track;
+
+    /* second side of double sided images */
+    if (fsimage->header.double_sided && track > 35) {
+        header.id1 = fsimage->header.id_side2[0];
+        header.id2 = fsimage->header.id_side2[1];
+        header.track = track - 35;
+    }
+
+    gap = disk_image_gap_size(image->type, track);
+
+    max_sector = disk_image_sector_per_track(image->type, track);
+
+    for (sector = 0; sector < max_sector; sector++) {
+        sectors = disk_image_check_sector(image, track, sector);
+
+        if (sectors >= 0) {
+            rf = CBMDOS_FDC_ERR_DRIVE;
+            if (fsimage_dxx_read_block(fsimage, buffer, sectors, base) >= 0) {
+                if (fsimage->error_info.map != NULL) {
+                    rf = fsimage->error_info.map[sectors];
+                }
+            }
+            header.sector = sector;
+            gcr_convert_sector_to_GCR(buffer, ptr, &header, 9, 5, rf);
+        }
+
+        ptr += SECTOR_GCR_SIZE_WITH_HEADER + 9 + gap + 5;
+    }
+    return 0;
+}
+
+int fsimage_read_dxx_image(const disk_image_t *image)
+{
+    uint8_t buffer[256], *bam_id;
+    fsimage_t *fsimage = image->media.fsimage;
+    int sectors;
+    long base;
+
+    base = (image->type == DISK_IMAGE_TYPE_X64) ? X64_HEADER_LENGTH : 0;
 
     if (image->type == DISK_IMAGE_TYPE_D80
         || image->type == DISK_IMAGE_TYPE_D82) {
@@ -168,86 +252,76 @@ int fsimage_read_dxx_image(const disk_image_t *image)
 
     bam_id[0] = bam_id[1] = 0xa0;
     if (sectors >= 0) {
-        util_fpread(fsimage->fd, buffer, 256, sectors << 8);
+        fsimage_dxx_read_block(fsimage, buffer, sectors, base);
     }
-    header.id1 = bam_id[0];
-    header.id2 = bam_id[1];
+    fsimage->header.id[0] = bam_id[0];
+    fsimage->header.id[1] = bam_id[1];
 
     /* check double sided images */
-    double_sided = (image->type == DISK_IMAGE_TYPE_D71) && !(buffer[0x03] & 0x80);
+    fsimage->header.double_sided = (image->type == DISK_IMAGE_TYPE_D71) && !(buffer[0x03] & 0x80);
 
-    for (header.track = track = 1; track <= image->max_half_tracks / 2; track++, header.track++) {
-        half_track = track * 2 - 2;
+    if (fsimage->header.double_sided) {
+        sectors = disk_image_check_sector(image, BAM_TRACK_1571 + 35, BAM_SECTOR_1571);
 
-        track_size = disk_image_raw_track_size(image->type, track);
-        if (image->gcr->tracks[half_track].data == NULL) {
-            image->gcr->tracks[half_track].data = lib_malloc(track_size);
-        } else if (image->gcr->tracks[half_track].size != (int)track_size) {
-            image->gcr->tracks[half_track].data = lib_realloc(image->gcr->tracks[half_track].data, track_size);
+        buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
+        if (sectors >= 0) {
+            fsimage_dxx_read_block(fsimage, buffer, sectors, base);
         }
-        ptr = image->gcr->tracks[half_track].data;
-        image->gcr->tracks[half_track].size = track_size;
-
-        if (track <= image->tracks) {
-            if (double_sided && track == 36) {
-                sectors = disk_image_check_sector(image, BAM_TRACK_1571 + 35, BAM_SECTOR_1571);
-
-                buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
-                if (sectors >= 0) {
-                    util_fpread(fsimage->fd, buffer, 256, sectors << 8);
-                }
-                header.id1 = buffer[BAM_ID_1571]; /* second side, update id and track */
-                header.id2 = buffer[BAM_ID_1571 + 1];
-                header.track = 1;
-            }
-
-            gap = disk_image_gap_size(image->type, track);
-
-            max_sector = disk_image_sector_per_track(image->type, track);
+        fsimage->header.id_side2[0] = buffer[BAM_ID_1571];
+        fsimage->header.id_side2[1] = buffer[BAM_ID_1571 + 1];
+    }
 
-            /* Clear track to avoid read errors.  */
-            memset(ptr, 0x55, track_size);
+    /* The tracks are converted when the drive head reaches them.  Tracks
+       already converted are kept, drive_enable() attaches the same image
+       again after reading a snapshot.  */
+    return 0;
+}
 
-            for (sector = 0; sector < max_sector; sector++) {
-                sectors = disk_image_check_sector(image, track, sector);
-                offset = sectors * 256;
+/* Tracks left out of a drive snapshot are converted from the image again,
+   the snapshot keeps the CRC of the sectors at attach to check it is the
+   same disk.  */
+void fsimage_dxx_attach_crc(const disk_image_t *image)
+{
+    uint8_t *data;
+    fsimage_t *fsimage = image->media.fsimage;
+    int total, i;
+    long base;
 
-                if (image->type == DISK_IMAGE_TYPE_X64) {
-                    offset += X64_HEADER_LENGTH;
-                }
+    fsimage->header.crc = 0;
 
-                if (sectors >= 0) {
-                    rf = CBMDOS_FDC_ERR_DRIVE;
-                    if (util_fpread(fsimage->fd, buffer, 256, offset) >= 0) {
-                        if (fsimage->error_info.map != NULL) {
-                            rf = fsimage->error_info.map[sectors];
-                        }
-                    }
-                    header.sector = sector;
-                    gcr_convert_sector_to_GCR(buffer, ptr, &header, 9, 5, rf);
-                }
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_X64:
+            break;
+        default:
+            return;
+    }
 
-                ptr += SECTOR_GCR_SIZE_WITH_HEADER + 9 + gap + 5;
-            }
-        } else {
-            memset(ptr, 0x55, track_size);
-        }
+    total = disk_image_check_sector(image, image->tracks, 0);
+    if (total < 0) {
+        return;
+    }
+    total += disk_image_sector_per_track(image->type, image->tracks);
 
-        /* Clear odd track */
-        half_track++;
-        if (image->gcr->tracks[half_track].data) {
-            lib_free(image->gcr->tracks[half_track].data);
-            image->gcr->tracks[half_track].data = NULL;
-            image->gcr->tracks[half_track].size = 0;
-        }
+    base = (image->type == DISK_IMAGE_TYPE_X64) ? X64_HEADER_LENGTH : 0;
+    data = lib_calloc(total, 257);
+    for (i = 0; i < total; i++) {
+        fsimage_dxx_read_block(fsimage, data + i * 256, i, base);
     }
-    return 0;
+    if (fsimage->error_info.map != NULL) {
+        memcpy(data + total * 256, fsimage->error_info.map,
+               fsimage->error_info.len < total ? fsimage->error_info.len : total);
+    }
+    fsimage->header.crc = crc32_buf((const char *)data, total * 257);
+    lib_free(data);
 }
 
 int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_addr_t *dadr)
 {
     int sectors;
-    long offset;
+    long base;
     fsimage_t *fsimage = image->media.fsimage;
     fdc_err_t rf;
 
@@ -259,14 +333,11 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
         return -1;
     }
 
-    offset = sectors * 256;
-
-    if (image->type == DISK_IMAGE_TYPE_X64) {
-        offset += X64_HEADER_LENGTH;
-    }
+    base = (image->type == DISK_IMAGE_TYPE_X64) ? X64_HEADER_LENGTH : 0;
 
-    if (image->gcr == NULL) {
-        if (util_fpread(fsimage->fd, buf, 256, offset) < 0) {
+    /* Tracks the drive head has not reached yet are not converted */
+    if (image->gcr == NULL || image->gcr->tracks[(dadr->track * 2) - 2].data == NULL) {
+        if (fsimage_dxx_read_block(fsimage, buf, sectors, base) < 0) {
             log_error(fsimage_dxx_log,
                       "Error reading T:%i S:%i from disk image.",
                       dadr->track, dadr->sector);
@@ -311,7 +382,7 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
 int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk_addr_t *dadr)
 {
     int sectors;
-    long offset;
+    long base, offset;
     fsimage_t *fsimage;
 
     fsimage = image->media.fsimage;
@@ -323,20 +394,22 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
                   dadr->track, dadr->sector);
         return -1;
     }
-    offset = sectors * 256;
+    base = (image->type == DISK_IMAGE_TYPE_X64) ? X64_HEADER_LENGTH : 0;
+    offset = base + sectors * 256;
 
-    if (image->type == DISK_IMAGE_TYPE_X64) {
-        offset += X64_HEADER_LENGTH;
-    }
-
-    if (util_fpwrite(fsimage->fd, buf, 256, offset) < 0) {
+    /* The sector goes to the file when the image is flushed */
+    if (fsimage_cache_write(fsimage, buf, sectors, 1, base) < 0
+        && util_fpwrite(fsimage->fd, buf, 256, offset) < 0) {
         log_error(fsimage_dxx_log, "Error writing T:%i S:%i to disk image.",
                   dadr->track, dadr->sector);
         return -1;
     }
-    if (image->gcr != NULL) {
+    if (image->gcr != NULL && image->gcr->tracks[(dadr->track * 2) - 2].data != NULL) {
         gcr_write_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
     }
+    if (image->gcr != NULL && image->gcr->pristine[(dadr->track * 2) - 2].data != NULL) {
+        gcr_write_sector(&image->gcr->pristine[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
+    }
 
     if ((fsimage->error_info.map != NULL)
         && (fsimage->error_info.map[sectors] != CBMDOS_FDC_ERR_OK)) {
@@ -353,8 +426,6 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
         }
     }
 
-    /* Make sure the stream is visible to other readers.  */
-    fflush(fsimage->fd);
     return 0;
 }
 
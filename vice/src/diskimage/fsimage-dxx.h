@@ -36,7 +36,10 @@ struct disk_addr_s;
 extern void fsimage_dxx_init(void);
 
 extern int fsimage_read_dxx_image(const disk_image_t *image);
+extern void fsimage_dxx_attach_crc(const disk_image_t *image);
 
+extern int fsimage_dxx_read_half_track(const struct disk_image_s *image, unsigned int half_track,
+                                       struct disk_track_s *raw);
 extern int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
                                         const struct disk_track_s *raw);
 extern int fsimage_dxx_read_sector(const struct disk_image_s *image, uint8_t *buf,
@@ -56,6 +56,7 @@ int fsimage_read_gcr_image(const disk_image_t *image)
 
     for (half_track = 0; half_track < MAX_GCR_TRACKS; half_track++) {
         if (image->gcr->tracks[half_track].data) {
+            gcr_invalidate_track(&image->gcr->tracks[half_track]);
             lib_free(image->gcr->tracks[half_track].data);
             image->gcr->tracks[half_track].data = NULL;
             image->gcr->tracks[half_track].size = 0;
@@ -129,6 +130,7 @@ int fsimage_gcr_read_half_track(const disk_image_t *image, unsigned int half_tra
 
     raw->data = NULL;
     raw->size = 0;
+    raw->index = NULL;
 
     offset = fsimage_gcr_seek_half_track(fsimage, half_track, &max_track_length, &num_half_tracks);
 
@@ -291,6 +293,7 @@ int fsimage_gcr_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
             return CBMDOS_IPE_NOT_READY;
         }
         rf = gcr_read_sector(&raw, buf, (uint8_t)dadr->sector);
+        gcr_invalidate_track(&raw);
         lib_free(raw.data);
     } else {
         rf = gcr_read_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
@@ -353,13 +356,16 @@ int fsimage_gcr_write_sector(disk_image_t *image, const uint8_t *buf,
             log_error(fsimage_gcr_log,
                       "Could not find track %i sector %i in disk image",
                       dadr->track, dadr->sector);
+            gcr_invalidate_track(&raw);
             lib_free(raw.data);
             return -1;
         }
         if (fsimage_gcr_write_track(image, dadr->track, &raw) < 0) {
+            gcr_invalidate_track(&raw);
             lib_free(raw.data);
             return -1;
         }
+        gcr_invalidate_track(&raw);
         lib_free(raw.data);
     } else {
         if (gcr_write_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector) != CBMDOS_FDC_ERR_OK) {
@@ -123,6 +123,7 @@ int fsimage_p64_read_half_track(const disk_image_t *image, unsigned int half_tra
 
     raw->data = NULL;
     raw->size = 0;
+    raw->index = NULL;
     if (P64Image == NULL) {
         log_error(fsimage_p64_log, "P64 image not loaded.");
         return -1;
@@ -220,6 +221,7 @@ int fsimage_p64_read_sector(const disk_image_t *image, uint8_t *buf,
     }
 
     rf = gcr_read_sector(&raw, buf, (uint8_t)dadr->sector);
+    gcr_invalidate_track(&raw);
     lib_free(raw.data);
     if (rf != CBMDOS_FDC_ERR_OK) {
         log_error(fsimage_p64_log, "Cannot find track: %i sector: %i within P64 image.", dadr->track, dadr->sector);
@@ -275,16 +277,19 @@ int fsimage_p64_write_sector(disk_image_t *image, const uint8_t *buf,
 
     if (gcr_write_sector(&raw, buf, (uint8_t)dadr->sector) != CBMDOS_FDC_ERR_OK) {
         log_error(fsimage_p64_log, "Could not find track %i sector %i in disk image", dadr->track, dadr->sector);
+        gcr_invalidate_track(&raw);
         lib_free(raw.data);
         return -1;
     }
 
     if (fsimage_p64_write_track(image, dadr->track, raw.size, raw.data) < 0) {
         log_error(fsimage_p64_log, "Failed writing track %i to disk image.", dadr->track);
+        gcr_invalidate_track(&raw);
         lib_free(raw.data);
         return -1;
     }
 
+    gcr_invalidate_track(&raw);
     lib_free(raw.data);
     return 0;
 }
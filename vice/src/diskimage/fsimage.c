@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "archdep.h"
 #include "diskconstants.h"
@@ -147,6 +148,7 @@ int fsimage_open(disk_image_t *image)
     }
 
     if (fsimage_probe(image) == 0) {
+        fsimage_dxx_attach_crc(image);
         return 0;
     }
 
@@ -170,6 +172,15 @@ int fsimage_close(disk_image_t *image)
         fsimage_write_p64_image(image);
     }*/
 
+    fsimage_cache_flush(fsimage);
+    if (fsimage->cache.data) {
+        lib_free(fsimage->cache.data);
+        lib_free(fsimage->cache.dirty);
+        fsimage->cache.data = NULL;
+        fsimage->cache.dirty = NULL;
+        fsimage->cache.sectors = 0;
+    }
+
     if (fsimage->error_info.map) {
         lib_free(fsimage->error_info.map);
         fsimage->error_info.map = NULL;
@@ -263,6 +274,134 @@ int fsimage_write_sector(disk_image_t *image, const uint8_t *buf,
     return 0;
 }
 
+int fsimage_flush(disk_image_t *image)
+{
+    fsimage_t *fsimage;
+
+    fsimage = image->media.fsimage;
+
+    if (fsimage->fd == NULL) {
+        return 0;
+    }
+    return fsimage_cache_flush(fsimage);
+}
+
+/*-----------------------------------------------------------------------*/
+/* Sector cache.  The sectors of D64 and similar images are read into
+   memory on first access, writes stay there until the image is flushed
+   or closed.  `offset' is where the first sector is in the file.  */
+
+static int fsimage_cache_load(fsimage_t *fsimage, long offset)
+{
+    size_t length;
+    unsigned int sectors;
+
+    if (fsimage->cache.data != NULL) {
+        return 0;
+    }
+
+    length = util_file_length(fsimage->fd);
+    length = (length > (size_t)offset) ? length - offset : 0;
+    sectors = (unsigned int)((length + 255) / 256);
+
+    fsimage->cache.data = lib_calloc(sectors + 1, 256);
+    if (length > 0 && util_fpread(fsimage->fd, fsimage->cache.data, length, offset) < 0) {
+        lib_free(fsimage->cache.data);
+        fsimage->cache.data = NULL;
+        return -1;
+    }
+    fsimage->cache.dirty = lib_calloc(sectors + 1, 1);
+    fsimage->cache.sectors = sectors;
+    fsimage->cache.offset = offset;
+
+    return 0;
+}
+
+int fsimage_cache_read(fsimage_t *fsimage, uint8_t *buf, unsigned int sector,
+                       long offset)
+{
+    if (fsimage_cache_load(fsimage, offset) < 0
+        || sector >= fsimage->cache.sectors) {
+        return -1;
+    }
+
+    memcpy(buf, fsimage->cache.data + sector * 256, 256);
+    return 0;
+}
+
+int fsimage_cache_write(fsimage_t *fsimage, const uint8_t *buf,
+                        unsigned int sector, unsigned int count, long offset)
+{
+    unsigned int sectors = sector + count;
+
+    if (fsimage_cache_load(fsimage, offset) < 0) {
+        return -1;
+    }
+
+    /* Writes may extend the image */
+    if (sectors > fsimage->cache.sectors) {
+        fsimage->cache.data = lib_realloc(fsimage->cache.data, sectors * 256);
+        fsimage->cache.dirty = lib_realloc(fsimage->cache.dirty, sectors);
+        memset(fsimage->cache.data + fsimage->cache.sectors * 256, 0,
+               (sectors - fsimage->cache.sectors) * 256);
+        memset(fsimage->cache.dirty + fsimage->cache.sectors, 0,
+               sectors - fsimage->cache.sectors);
+        fsimage->cache.sectors = sectors;
+    }
+
+    memcpy(fsimage->cache.data + sector * 256, buf, count * 256);
+    memset(fsimage->cache.dirty + sector, 1, count);
+    return 0;
+}
+
+/* Sectors that were written to the file directly */
+void fsimage_cache_update(fsimage_t *fsimage, const uint8_t *buf,
+                          unsigned int sector, unsigned int count)
+{
+    if (fsimage->cache.data == NULL) {
+        return;
+    }
+    if (sector >= fsimage->cache.sectors) {
+        return;
+    }
+    if (count > fsimage->cache.sectors - sector) {
+        count = fsimage->cache.sectors - sector;
+    }
+
+    memcpy(fsimage->cache.data + sector * 256, buf, count * 256);
+    memset(fsimage->cache.dirty + sector, 0, count);
+}
+
+int fsimage_cache_flush(fsimage_t *fsimage)
+{
+    unsigned int first, last;
+    int rc = 0;
+
+    for (first = 0; first < fsimage->cache.sectors; first = last) {
+        last = first + 1;
+        if (!fsimage->cache.dirty[first]) {
+            continue;
+        }
+        while (last < fsimage->cache.sectors && fsimage->cache.dirty[last]) {
+            last++;
+        }
+
+        if (util_fpwrite(fsimage->fd, fsimage->cache.data + first * 256,
+                         (last - first) * 256,
+                         fsimage->cache.offset + (long)first * 256) < 0) {
+            log_error(fsimage_log, "Error writing sectors %u-%u to disk image `%s'.",
+                      first, last - 1, fsimage->name);
+            rc = -1;
+            continue;
+        }
+        memset(fsimage->cache.dirty + first, 0, last - first);
+    }
+
+    /* Make sure the stream is visible to other readers.  */
+    fflush(fsimage->fd);
+    return rc;
+}
+
 /*-----------------------------------------------------------------------*/
 
 void fsimage_init(void)
@@ -42,6 +42,21 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    /* Sectors of the image kept in memory, written back by fsimage_flush() */
+    struct {
+        uint8_t *data;
+        uint8_t *dirty;
+        unsigned int sectors;
+        long offset;
+    } cache;
+    /* Disk IDs of the GCR sector headers, read from the BAM at attach */
+    struct {
+        uint8_t id[2];
+        uint8_t id_side2[2];
+        int double_sided;
+        /* CRC32 of the sectors at attach, drive snapshots check it */
+        uint32_t crc;
+    } header;
 } fsimage_t;
 
 
@@ -59,5 +74,14 @@ extern int fsimage_read_sector(const struct disk_image_s *image, uint8_t *buf,
                                const struct disk_addr_s *dadr);
 extern int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
                                 const struct disk_addr_s *dadr);
+extern int fsimage_flush(struct disk_image_s *image);
+
+extern int fsimage_cache_read(fsimage_t *fsimage, uint8_t *buf, unsigned int sector,
+                              long offset);
+extern int fsimage_cache_write(fsimage_t *fsimage, const uint8_t *buf,
+                               unsigned int sector, unsigned int count, long offset);
+extern void fsimage_cache_update(fsimage_t *fsimage, const uint8_t *buf,
+                                 unsigned int sector, unsigned int count);
+extern int fsimage_cache_flush(fsimage_t *fsimage);
 
 #endif
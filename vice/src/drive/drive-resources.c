@@ -294,6 +294,18 @@ static int set_drive_idling_method(int val, void *param)
     return 0;
 }
 
+static int set_drive_idle_loop_skip(int val, void *param)
+{
+    unsigned int dnr;
+    drive_t *drive;
+
+    dnr = vice_ptr_to_uint(param);
+    drive = drive_context[dnr]->drive;
+
+    drive->idle_loop_skip = val ? 1 : 0;
+    return 0;
+}
+
 static int set_drive_rpm(int val, void *param)
 {
     unsigned int dnr;
@@ -350,6 +362,8 @@ static resource_int_t res_drive[] = {
       NULL, set_drive_rpm, NULL },
     { NULL, 50, RES_EVENT_SAME, NULL,
       NULL, set_drive_rpm_wobble, NULL },
+    { NULL, 0, RES_EVENT_SAME, NULL,
+      NULL, set_drive_idle_loop_skip, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -393,6 +407,9 @@ int drive_resources_init(void)
         res_drive[3].name = lib_msprintf("Drive%iWobble", dnr + 8);
         res_drive[3].value_ptr = &(drive->rpm_wobble);
         res_drive[3].param = uint_to_void_ptr(dnr);
+        res_drive[4].name = lib_msprintf("Drive%iIdleLoopSkip", dnr + 8);
+        res_drive[4].value_ptr = &(drive->idle_loop_skip);
+        res_drive[4].param = uint_to_void_ptr(dnr);
 
         if (has_iec) {
             res_drive_rtc[0].name = lib_msprintf("Drive%iRTCSave", dnr + 8);
@@ -407,7 +424,7 @@ int drive_resources_init(void)
             return -1;
         }
 
-        for (i = 0; i < 4; i++) {
+        for (i = 0; i < 5; i++) {
             lib_free(res_drive[i].name);
         }
         if (has_iec) {
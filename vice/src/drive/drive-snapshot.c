@@ -905,7 +905,7 @@ static int drive_snapshot_read_image_module(snapshot_t *s, unsigned int dnr)
 /* read/write GCR disk image snapshot module */
 
 #define GCRIMAGE_SNAP_MAJOR 3
-#define GCRIMAGE_SNAP_MINOR 1
+#define GCRIMAGE_SNAP_MINOR 3
 
 static int drive_snapshot_write_gcrimage_module(snapshot_t *s, unsigned int dnr)
 {
@@ -915,6 +915,7 @@ static int drive_snapshot_write_gcrimage_module(snapshot_t *s, unsigned int dnr)
     unsigned int i;
     drive_t *drive;
     uint32_t num_half_tracks, track_size;
+    int lazy;
 
     drive = drive_context[dnr]->drive;
     sprintf(snap_module_name, "GCRIMAGE%i", dnr);
@@ -927,8 +928,16 @@ static int drive_snapshot_write_gcrimage_module(snapshot_t *s, unsigned int dnr)
 
     num_half_tracks = MAX_TRACKS_1571 * 2;
 
+    /* Tracks of a D64 the head has not reached yet are left out, they are
+       converted from the attached image again after reading the snapshot.
+       The CRC of the image at attach makes sure it is the same disk.  */
+    lazy = drive_gcr_data_lazy(drive);
+
     /* Write general data */
-    if (SMW_DW(m, num_half_tracks) < 0) {
+    if (0
+        || SMW_DW(m, num_half_tracks) < 0
+        || SMW_B(m, (uint8_t)lazy) < 0
+        || (lazy && SMW_DW(m, disk_image_attach_crc(drive->image)) < 0)) {
         snapshot_module_close(m);
         return -1;
     }
@@ -940,6 +949,7 @@ static int drive_snapshot_write_gcrimage_module(snapshot_t *s, unsigned int dnr)
         if (0
             || SMW_DW(m, (uint32_t)track_size) < 0
             || (track_size && SMW_BA(m, data, track_size) < 0)
+            || (lazy && track_size && SMW_B(m, drive->gcr->written[i]) < 0)
             ) {
             break;
         }
@@ -960,7 +970,8 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
     uint8_t *data;
     unsigned int i;
     drive_t *drive;
-    uint32_t num_half_tracks, track_size;
+    uint32_t num_half_tracks, track_size, crc;
+    int lazy = 0;
 
     drive = drive_context[dnr]->drive;
     sprintf(snap_module_name, "GCRIMAGE%i", dnr);
@@ -972,7 +983,7 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
     }
 
     if (major_version != GCRIMAGE_SNAP_MAJOR
-        || minor_version != GCRIMAGE_SNAP_MINOR) {
+        || minor_version < 1 || minor_version > GCRIMAGE_SNAP_MINOR) {
         log_error(drive_snapshot_log,
                   "Snapshot module version (%d.%d) not supported.",
                   major_version, minor_version);
@@ -983,11 +994,33 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
 
     if (0
         || SMR_DW(m, &num_half_tracks) < 0
-        || num_half_tracks > MAX_GCR_TRACKS) {
+        || num_half_tracks > MAX_GCR_TRACKS
+        || (minor_version >= 2 && SMR_B_INT(m, &lazy) < 0)) {
         snapshot_module_close(m);
         return -1;
     }
 
+    /* The tracks left out come from the image */
+    if (lazy && !drive_gcr_data_lazy(drive)) {
+        log_error(drive_snapshot_log,
+                  "Snapshot of drive %u needs its disk image attached.", dnr + 8);
+        snapshot_module_close(m);
+        return -1;
+    }
+
+    if (lazy && minor_version >= 3) {
+        if (SMR_DW(m, &crc) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
+        if (crc != disk_image_attach_crc(drive->image)) {
+            log_error(drive_snapshot_log,
+                      "Snapshot of drive %u was saved with another disk image.", dnr + 8);
+            snapshot_module_close(m);
+            return -1;
+        }
+    }
+
     for (i = 0; i < num_half_tracks; i++) {
         if (SMR_DW(m, &track_size) < 0
             || track_size > NUM_MAX_MEM_BYTES_TRACK) {
@@ -1004,20 +1037,28 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
             memset(drive->gcr->tracks[i].data, 0, track_size);
         } else {
             if (drive->gcr->tracks[i].data) {
+                gcr_invalidate_track(&drive->gcr->tracks[i]);
                 lib_free(drive->gcr->tracks[i].data);
                 drive->gcr->tracks[i].data = NULL;
             }
         }
         data = drive->gcr->tracks[i].data;
         drive->gcr->tracks[i].size = track_size;
+        gcr_invalidate_track(&drive->gcr->tracks[i]);
 
         if (track_size && SMR_BA(m, data, track_size) < 0) {
             snapshot_module_close(m);
             return -1;
         }
+        drive->gcr->written[i] = 0;
+        if (lazy && track_size && SMR_B(m, &drive->gcr->written[i]) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
     }
     for (; i < MAX_GCR_TRACKS; i++) {
         if (drive->gcr->tracks[i].data) {
+            gcr_invalidate_track(&drive->gcr->tracks[i]);
             lib_free(drive->gcr->tracks[i].data);
             drive->gcr->tracks[i].data = NULL;
             drive->gcr->tracks[i].size = 0;
@@ -1027,7 +1068,9 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
 
     drive->GCR_image_loaded = 1;
     drive->complicated_image_loaded = 1; /* TODO: verify if it's really like this */
-    drive->image = NULL;
+    if (!lazy) {
+        drive->image = NULL;
+    }
 
     return 0;
 }
@@ -73,6 +73,14 @@
 #include "p64.h"
 #include "monitor.h"
 
+#ifdef __LIBRETRO__
+#include "libretro-core.h"
+#include "retro_perf.h"
+#else
+#define RETRO_PERF_BEGIN(id)
+#define RETRO_PERF_END(id)
+#endif
+
 static int drive_init_was_called = 0;
 
 drive_context_t *drive_context[DRIVE_NUM];
@@ -109,6 +117,7 @@ void drive_set_disk_memory(uint8_t *id, unsigned int track, unsigned int sector,
         drv->drive->drive_ram[0x18] = track;
         drv->drive->drive_ram[0x19] = sector;
         drv->drive->drive_ram[0x22] = track;
+        drv->drive->ram_generation++;
     }
 }
 
@@ -139,6 +148,7 @@ void drive_set_last_read(unsigned int track, unsigned int sector, uint8_t *buffe
         || drive->type == DRIVE_TYPE_1571
         || drive->type == DRIVE_TYPE_1571CR) {
         memcpy(&(drv->drive->drive_ram[0x0400]), buffer, 256);
+        drv->drive->ram_generation++;
     }
 }
 
@@ -544,6 +554,81 @@ void drive_reset(void)
     }
 }
 
+/* D64 images are converted to GCR one track at a time, when the head
+   reaches the track.  */
+int drive_gcr_data_lazy(const drive_t *drive)
+{
+    if (drive->image == NULL) {
+        return 0;
+    }
+
+    switch (drive->image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_X64:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void drive_gcr_data_load(drive_t *drive, unsigned int half_track)
+{
+    disk_track_t *raw, *pristine;
+
+    if (!drive_gcr_data_lazy(drive)
+        || half_track < 2 || half_track > drive->image->max_half_tracks
+        || (half_track & 1)) {
+        return;
+    }
+
+    raw = &drive->gcr->tracks[half_track - 2];
+    if (raw->data == NULL) {
+        pristine = &drive->gcr->pristine[half_track - 2];
+        if (pristine->data) {
+            /* The image holds a later write of the drive */
+            raw->data = lib_malloc(pristine->size);
+            memcpy(raw->data, pristine->data, pristine->size);
+            raw->size = pristine->size;
+        } else {
+            disk_image_read_half_track(drive->image, half_track, raw);
+        }
+#ifdef __LIBRETRO__
+        /* The snapshot holds the converted tracks */
+        snapshot_size_invalidate();
+#endif
+    }
+}
+
+/* Free the track under the head, unless the drive wrote to it.  */
+static void drive_gcr_data_unload(drive_t *drive)
+{
+    unsigned int half_track;
+    disk_track_t *raw;
+
+    if (!drive_gcr_data_lazy(drive) || drive->GCR_dirty_track) {
+        return;
+    }
+
+    half_track = drive->current_half_track + (drive->side * 70);
+    if (half_track < 2 || half_track - 2 >= MAX_GCR_TRACKS
+        || drive->gcr->written[half_track - 2]) {
+        return;
+    }
+
+    raw = &drive->gcr->tracks[half_track - 2];
+    if (raw->data) {
+        gcr_invalidate_track(raw);
+        lib_free(raw->data);
+        raw->data = NULL;
+        raw->size = 0;
+#ifdef __LIBRETRO__
+        snapshot_size_invalidate();
+#endif
+    }
+}
+
 /* Move the head to half track `num'.  */
 void drive_set_half_track(int num, int side, drive_t *dptr)
 {
@@ -565,6 +650,7 @@ void drive_set_half_track(int num, int side, drive_t *dptr)
     }
 
     if (dptr->current_half_track != num || dptr->side != side) {
+        drive_gcr_data_unload(dptr);
         dptr->current_half_track = num;
         if (dptr->p64) {
             dptr->p64->PulseStreams[dptr->side][dptr->current_half_track].CurrentIndex = -1;
@@ -575,6 +661,7 @@ void drive_set_half_track(int num, int side, drive_t *dptr)
     /* FIXME: why would the offset be different for D71 and G71? */
     tmp = (dptr->image && dptr->image->type == DISK_IMAGE_TYPE_G71) ? DRIVE_HALFTRACKS_1571 : 70;
 
+    drive_gcr_data_load(dptr, dptr->current_half_track + (dptr->side * tmp));
     dptr->GCR_track_start_ptr = dptr->gcr->tracks[dptr->current_half_track - 2 + (dptr->side * tmp)].data;
 
     if (dptr->GCR_current_track_size != 0) {
@@ -623,6 +710,19 @@ void drive_gcr_data_writeback(drive_t *drive)
         return;
     }
 
+    /* The drive CPU may have moved the sector headers */
+    gcr_invalidate_track(&drive->gcr->tracks[half_track - 2]);
+
+    /* Keep the track as it was at attach, snapshots taken before this
+       write convert it again from there */
+    if (drive_gcr_data_lazy(drive)
+        && drive->gcr->pristine[half_track - 2].data == NULL
+        && half_track <= drive->image->max_half_tracks) {
+        disk_image_read_half_track(drive->image, half_track,
+                                   &drive->gcr->pristine[half_track - 2]);
+    }
+    drive->gcr->written[half_track - 2] = 1;
+
     if ((drive->image->type == DISK_IMAGE_TYPE_G64)
         || (drive->image->type == DISK_IMAGE_TYPE_G71)) {
         disk_image_write_half_track(drive->image, half_track,
@@ -675,6 +775,7 @@ void drive_gcr_data_writeback_all(void)
     for (i = 0; i < DRIVE_NUM; i++) {
         drive = drive_context[i]->drive;
         drive_gcr_data_writeback(drive);
+        disk_image_flush(drive->image);
         if (drive->P64_image_loaded && drive->image && drive->image->p64) {
             if (drive->image->type == DISK_IMAGE_TYPE_P64) {
                 if (drive->P64_dirty) {
@@ -798,11 +899,13 @@ void drive_cpu_execute_one(drive_context_t *drv, CLOCK clk_value)
 {
     drive_t *drive = drv->drive;
 
+    RETRO_PERF_BEGIN(RETRO_PERF_DRIVE);
     if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
         drivecpu65c02_execute(drv, clk_value);
     } else {
         drivecpu_execute(drv, clk_value);
     }
+    RETRO_PERF_END(RETRO_PERF_DRIVE);
 }
 
 void drive_cpu_execute_all(CLOCK clk_value)
@@ -184,6 +184,9 @@ typedef struct drive_s {
     /* What idling method?  (See `DRIVE_IDLE_*')  */
     int idling_method;
 
+    /* Skip the passes of the DOS idle loop that change nothing?  */
+    int idle_loop_skip;
+
     /* FD2000/4000 RTC save? */
     int rtc_save;
 
@@ -325,6 +328,9 @@ typedef struct drive_s {
     /* Drive RAM */
     uint8_t drive_ram[DRIVE_RAM_SIZE];
 
+    /* Changes whenever the drive RAM may have, for SMW_BA_GEN */
+    unsigned int ram_generation;
+
     /* rotations per minute (300rpm = 30000) */
     int rpm;
     int rpm_wobble;
@@ -358,6 +364,7 @@ extern void drive_vsync_hook(void);
 extern int drive_get_disk_drive_type(int dnr);
 extern void drive_enable_update_ui(struct drive_context_s *drv);
 extern void drive_update_ui_status(void);
+extern int drive_gcr_data_lazy(const struct drive_s *drive);
 extern void drive_gcr_data_writeback(struct drive_s *drive);
 extern void drive_gcr_data_writeback_all(void);
 extern void drive_set_active_led_color(unsigned int type, unsigned int dnr);
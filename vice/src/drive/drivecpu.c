@@ -299,6 +299,59 @@ inline static uint32_t drive_trap_handler(drive_context_t *drv)
     return (uint32_t)-1;
 }
 
+/* The DOS of the 1541 and 1571 families ends its idle loop with a JMP back
+   to the top, at the same address in every ROM.  With no ATN pending, the
+   error LED not blinking, the motor off and no interrupt pending, a pass of
+   the loop changes nothing, so with the `DriveXIdleLoopSkip' resource set
+   the passes until the next alarm are skipped like the `trap idle' method
+   does.  The drive then reaches its next event in the same state, only the
+   position in the loop where an interrupt hits may differ.  */
+#define DRIVE_IDLE_LOOP_END 0xec9b
+#define DRIVE_IDLE_LOOP     0xebff
+
+inline static int drive_idle_skip(drive_context_t *drv)
+{
+    drive_t *drive = drv->drive;
+    CLOCK next_clk;
+
+    switch (drive->type) {
+        case DRIVE_TYPE_1540:
+        case DRIVE_TYPE_1541:
+        case DRIVE_TYPE_1541II:
+        case DRIVE_TYPE_1570:
+        case DRIVE_TYPE_1571:
+        case DRIVE_TYPE_1571CR:
+            break;
+        default:
+            return 0;
+    }
+
+    /* `trap idle' patches the same instruction */
+    if (!drive->idle_loop_skip
+        || drive->idling_method == DRIVE_IDLE_TRAP_IDLE
+        || drive->rom[DRIVE_IDLE_LOOP_END - 0x8000] != 0x4c
+        || drive->rom[DRIVE_IDLE_LOOP_END - 0x8000 + 1] != (DRIVE_IDLE_LOOP & 0xff)
+        || drive->rom[DRIVE_IDLE_LOOP_END - 0x8000 + 2] != (DRIVE_IDLE_LOOP >> 8)
+        || drive->drive_ram[0x7c] != 0
+        || drive->drive_ram[0x26c] != 0
+        || (drive->byte_ready_active & 0x04) != 0
+        || drv->cpu->int_status->global_pending_int != IK_NONE) {
+        return 0;
+    }
+
+    next_clk = alarm_context_next_pending_clk(drv->cpu->alarm_context);
+
+    if (next_clk > drv->cpu->stop_clk) {
+        next_clk = drv->cpu->stop_clk;
+    }
+    if (next_clk <= *(drv->clk_ptr)) {
+        return 0;
+    }
+
+    *(drv->clk_ptr) = next_clk;
+    return 1;
+}
+
 static void drive_generic_dma(void)
 {
     /* Generic DMA hosts can be implemented here.
@@ -405,8 +458,15 @@ void drivecpu_execute(drive_context_t *drv, CLOCK clk_value)
     /* Run drive CPU emulation until the stop_clk clock has been reached.
      * There appears to be a nasty 32-bit overflow problem here, so we
      * paper over it by only considering subtractions of 2nd complement
-     * integers. */
+     * integers.  The RAM is taken as changed whenever the CPU runs. */
+    if ((int) (*(drv->clk_ptr) - cpu->stop_clk) < 0) {
+        drv->drive->ram_generation++;
+    }
     while ((int) (*(drv->clk_ptr) - cpu->stop_clk) < 0) {
+        if (reg_pc == DRIVE_IDLE_LOOP_END && drive_idle_skip(drv)) {
+            continue;
+        }
+
 /* Include the 6502/6510 CPU emulation core.  */
 
 #define CLK (*(drv->clk_ptr))
@@ -597,7 +657,7 @@ int drivecpu_snapshot_write_module(drive_context_t *drv, snapshot_t *s)
         || drv->drive->type == DRIVE_TYPE_1571
         || drv->drive->type == DRIVE_TYPE_1571CR
         || drv->drive->type == DRIVE_TYPE_2031) {
-        if (SMW_BA(m, drv->drive->drive_ram, 0x800) < 0) {
+        if (SMW_BA_GEN(m, drv->drive->drive_ram, 0x800, drv->drive->ram_generation) < 0) {
             goto fail;
         }
     }
@@ -605,7 +665,7 @@ int drivecpu_snapshot_write_module(drive_context_t *drv, snapshot_t *s)
     if (drv->drive->type == DRIVE_TYPE_1581
         || drv->drive->type == DRIVE_TYPE_2000
         || drv->drive->type == DRIVE_TYPE_4000) {
-        if (SMW_BA(m, drv->drive->drive_ram, 0x2000) < 0) {
+        if (SMW_BA_GEN(m, drv->drive->drive_ram, 0x2000, drv->drive->ram_generation) < 0) {
             goto fail;
         }
     }
@@ -708,6 +768,8 @@ int drivecpu_snapshot_read_module(drive_context_t *drv, snapshot_t *s)
         }
     }
 
+    drv->drive->ram_generation++;
+
     /* Update `*bank_base'.  */
     JUMP(reg_pc);
 
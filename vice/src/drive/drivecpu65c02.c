@@ -395,7 +395,10 @@ void drivecpu65c02_execute(drive_context_t *drv, CLOCK clk_value)
     /* Run drive CPU emulation until the stop_clk clock has been reached.
      * There appears to be a nasty 32-bit overflow problem here, so we
      * paper over it by only considering subtractions of 2nd complement
-     * integers. */
+     * integers.  The RAM is taken as changed whenever the CPU runs. */
+    if ((int) (*(drv->clk_ptr) - cpu->stop_clk) < 0) {
+        drv->drive->ram_generation++;
+    }
     while ((int) (*(drv->clk_ptr) - cpu->stop_clk) < 0) {
 /* Include the R65C02 CPU emulation core.  */
 
@@ -494,7 +497,7 @@ int drivecpu65c02_snapshot_write_module(drive_context_t *drv, snapshot_t *s)
 
     if (drv->drive->type == DRIVE_TYPE_2000
         || drv->drive->type == DRIVE_TYPE_4000) {
-        if (SMW_BA(m, drv->drive->drive_ram, 0x2000) < 0) {
+        if (SMW_BA_GEN(m, drv->drive->drive_ram, 0x2000, drv->drive->ram_generation) < 0) {
             goto fail;
         }
     }
@@ -572,6 +575,8 @@ int drivecpu65c02_snapshot_read_module(drive_context_t *drv, snapshot_t *s)
         }
     }
 
+    drv->drive->ram_generation++;
+
     /* Update `*bank_base'.  */
     JUMP(reg_pc);
 
@@ -223,10 +223,18 @@ int drive_image_detach(disk_image_t *image, unsigned int unit)
 
     for (i = 0; i < MAX_GCR_TRACKS; i++) {
         if (drive->gcr->tracks[i].data) {
+            gcr_invalidate_track(&drive->gcr->tracks[i]);
             lib_free(drive->gcr->tracks[i].data);
             drive->gcr->tracks[i].data = NULL;
             drive->gcr->tracks[i].size = 0;
         }
+        if (drive->gcr->pristine[i].data) {
+            gcr_invalidate_track(&drive->gcr->pristine[i]);
+            lib_free(drive->gcr->pristine[i].data);
+            drive->gcr->pristine[i].data = NULL;
+            drive->gcr->pristine[i].size = 0;
+        }
+        drive->gcr->written[i] = 0;
     }
     drive->detach_clk = drive_clk[dnr];
     drive->GCR_image_loaded = 0;
@@ -168,6 +168,7 @@ void drivemem_bank_store(int bank, uint16_t addr, uint8_t value, void *context)
     drive_context_t *drv = (drive_context_t *)context;
 
     drv->cpud->store_func_ptr[addr >> 8](drv, addr, value);
+    drv->drive->ram_generation++;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -349,10 +349,23 @@ static uint8_t store_pcr(via_context_t *via_context, uint8_t byte, uint16_t addr
 static void undump_pcr(via_context_t *via_context, uint8_t byte)
 {
     drivevia2_context_t *via2p;
+#if !OLDCODE
+    drive_t *dptr;
+#endif
 
     via2p = (drivevia2_context_t *)(via_context->prv);
 
+#if OLDCODE
     via2d_update_pcr(byte, via2p->drive);
+#else
+    /* Head mode and byte ready follow the CB2 and CA2 lines, the PCR bits
+       alone would put a drive still in input mode into write mode */
+    dptr = via2p->drive;
+    rotation_rotate_disk(dptr);
+    dptr->read_write_mode = via_context->cb2_state ? 0x20 : 0;
+    dptr->byte_ready_active = (dptr->byte_ready_active & ~0x02)
+                              | (via_context->ca2_state ? 0x02 : 0);
+#endif
 }
 
 static void undump_acr(via_context_t *via_context, uint8_t byte)
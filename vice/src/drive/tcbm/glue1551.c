@@ -94,6 +94,7 @@ static void glue_pport_update(drive_context_t *drv)
             | (drv->drive->byte_ready_level ? 0x80 : 0);
 
     drv->drive->drive_ram[1] = output & (input | ~0x90);
+    drv->drive->ram_generation++;
 
     old_output = output;
 }
@@ -71,6 +71,9 @@ typedef struct flash040_context_s {
     uint8_t erase_mask[FLASH040_ERASE_MASK_SIZE];
     int flash_dirty;
 
+    /* Changes whenever flash_data does, for SMW_BA_GEN */
+    unsigned int generation;
+
     flash040_type_t flash_type;
 
     uint8_t last_read;
@@ -230,16 +230,36 @@ static void gcr_decode_block(const disk_track_t *raw, int p, uint8_t *buf, int n
     }
 }
 
-static int gcr_find_sector_header(const disk_track_t *raw, uint8_t sector)
+/* Bit offsets of the sector headers of a track, so that reading a sector
+   doesn't scan the track for its header every time.  gcr_write_sector()
+   leaves the headers where they are, anything else that changes the track
+   data calls gcr_invalidate_track().  */
+typedef struct gcr_track_index_s {
+    /* Track the index was built for */
+    const uint8_t *data;
+    int size;
+    /* Position of the first header of each sector, -1 if there is none */
+    int header[256];
+    /* The track has no sync at all */
+    int no_sync;
+} gcr_track_index_t;
+
+static void gcr_build_index(const disk_track_t *raw, gcr_track_index_t *index)
 {
     uint8_t header[4];
-    int p, p2;
+    int i, p, p2;
+
+    index->data = raw->data;
+    index->size = raw->size;
+    for (i = 0; i < 256; i++) {
+        index->header[i] = -1;
+    }
 
     p = 0;
     p2 = -CBMDOS_FDC_ERR_SYNC;
     for (;; ) {
         p = gcr_find_sync(raw, p, raw->size * 8);
-        if (p2 == p) {
+        if (p2 == p || p < 0) {
             break;
         }
         if (p2 < 0) {
@@ -247,16 +267,58 @@ static int gcr_find_sector_header(const disk_track_t *raw, uint8_t sector)
         }
         gcr_decode_block(raw, p, header, 1);
 
-        if (header[0] == 0x08 && header[2] == sector) {
+        if (header[0] == 0x08 && index->header[header[2]] < 0) {
             /* Track, checksum or ID's are not checked here */
-            DBG(("GCR: shift: %d hdr: %02x %02x sec:%02d trk:%02d", shift, header[0], header[1], header[2], header[3]));
-            return p;
+            DBG(("GCR: hdr: %02x %02x sec:%02d trk:%02d", header[0], header[1], header[2], header[3]));
+            index->header[header[2]] = p;
         }
     }
-    if (p2 < 0) {
-        return p2;
+    index->no_sync = (p2 < 0);
+}
+
+static int gcr_find_sector_header(const disk_track_t *raw, uint8_t sector)
+{
+    /* The index only caches what is on the track */
+    disk_track_t *track = (disk_track_t *)raw;
+    gcr_track_index_t *index = track->index;
+    uint8_t header[4];
+    int p;
+
+    if (!raw->data || !raw->size) {
+        return -CBMDOS_FDC_ERR_SYNC;
+    }
+
+    if (index != NULL && index->data == raw->data && index->size == raw->size) {
+        p = index->header[sector];
+        if (p >= 0) {
+            /* Check the header is still there in case the track was written
+               without invalidating the index */
+            gcr_decode_block(raw, p, header, 1);
+            if (header[0] == 0x08 && header[2] == sector) {
+                return p;
+            }
+        }
+    }
+
+    if (index == NULL) {
+        index = lib_malloc(sizeof(gcr_track_index_t));
+        track->index = index;
+    }
+    gcr_build_index(raw, index);
+
+    if (index->no_sync) {
+        return -CBMDOS_FDC_ERR_SYNC;
+    }
+    p = index->header[sector];
+    return (p >= 0) ? p : -CBMDOS_FDC_ERR_HEADER;
+}
+
+void gcr_invalidate_track(disk_track_t *raw)
+{
+    if (raw->index) {
+        lib_free(raw->index);
+        raw->index = NULL;
     }
-    return -CBMDOS_FDC_ERR_HEADER;
 }
 
 fdc_err_t gcr_read_sector(const disk_track_t *raw, uint8_t *data, uint8_t sector)
@@ -351,6 +413,13 @@ gcr_t *gcr_create_image(void)
 
 void gcr_destroy_image(gcr_t *gcr)
 {
+    int i;
+
+    for (i = 0; i < MAX_GCR_TRACKS; i++) {
+        gcr_invalidate_track(&gcr->tracks[i]);
+        gcr_invalidate_track(&gcr->pristine[i]);
+        lib_free(gcr->pristine[i].data);
+    }
     lib_free(gcr);
     return;
 }
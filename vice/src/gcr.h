@@ -49,11 +49,18 @@
 typedef struct disk_track_s {
     uint8_t *data;
     int size;
+    /* Sector header positions, built on demand by gcr_read_sector() */
+    struct gcr_track_index_s *index;
 } disk_track_t;
 
 typedef struct gcr_s {
     /* Raw GCR image of the disk.  */
     disk_track_t tracks[MAX_GCR_TRACKS];
+    /* Tracks the drive wrote to, they can't be converted from a D64 again.  */
+    uint8_t written[MAX_GCR_TRACKS];
+    /* Written tracks as converted at attach, snapshots taken before the
+       write are restored from these instead of the changed image.  */
+    disk_track_t pristine[MAX_GCR_TRACKS];
 } gcr_t;
 
 typedef struct gcr_header_s {
@@ -64,6 +71,7 @@ extern void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *ptr, const
                                       int gap, int sync, enum fdc_err_e error_code);
 extern enum fdc_err_e gcr_read_sector(const disk_track_t *raw, uint8_t *data, uint8_t sector);
 extern enum fdc_err_e gcr_write_sector(disk_track_t *raw, const uint8_t *data, uint8_t sector);
+extern void gcr_invalidate_track(disk_track_t *raw);
 
 extern gcr_t *gcr_create_image(void);
 extern void gcr_destroy_image(gcr_t *gcr);
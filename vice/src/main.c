@@ -100,6 +100,9 @@ int main_program(int argc, char **argv)
     int ishelp = 0;
     char term_tmp[TERM_TMP_SIZE];
     size_t name_len;
+#ifdef __LIBRETRO__
+    int running;
+#endif
 
 
     lib_init_rand();
@@ -277,7 +280,15 @@ int main_program(int argc, char **argv)
     log_message(LOG_DEFAULT, "Main CPU: starting at ($FFFC).");
 
 #ifdef __LIBRETRO__
+    /* Only reset the CPU with its first opcode, retro_run() runs the frames.
+       A negative cpuloop stops the CPU after one opcode, without losing a
+       vsync that has cleared it, e.g. on the autostart reset.  */
+    running = cpuloop;
+    cpuloop = -1;
     maincpu_mainloop_retro();
+    if (cpuloop < 0) {
+        cpuloop = running;
+    }
 #else
     maincpu_mainloop();
 #endif
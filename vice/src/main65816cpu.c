@@ -237,8 +237,7 @@ void maincpu_resync_limits(void) {
     }
 }
 
-#ifdef __LIBRETRO__
-void maincpu_mainloop_retro(void)
+void maincpu_mainloop(void)
 {
     /* Notice that using a struct for these would make it a lot slower (at
        least, on gcc 2.7.2.x).  */
@@ -256,28 +255,25 @@ void maincpu_mainloop_retro(void)
 #define reg_b regs65802.reg_q[0]
 #endif
 
-static    uint16_t reg_x = 0;
-static    uint16_t reg_y = 0;
-static    uint8_t reg_pbr = 0;
-static    uint8_t reg_dbr = 0;
-static    uint16_t reg_dpr = 0;
-static    uint8_t reg_p = 0;
-static    uint16_t reg_sp = 0x100;
-static    uint8_t flag_n = 0;
-static    uint8_t flag_z = 0;
-static    uint8_t reg_emul = 1;
-static    int interrupt65816 = IK_RESET;
+    uint16_t reg_x = 0;
+    uint16_t reg_y = 0;
+    uint8_t reg_pbr = 0;
+    uint8_t reg_dbr = 0;
+    uint16_t reg_dpr = 0;
+    uint8_t reg_p = 0;
+    uint16_t reg_sp = 0x100;
+    uint8_t flag_n = 0;
+    uint8_t flag_z = 0;
+    uint8_t reg_emul = 1;
+    int interrupt65816 = IK_RESET;
 #ifndef NEED_REG_PC
-static    unsigned int reg_pc;
+    unsigned int reg_pc;
 #endif
-static    uint8_t *bank_base;
-static    int bank_start = 0;
-static    int bank_limit = 0;
-static    uint8_t bank_bank = 0;
-
-static int first1=0;
-if(first1==0){
-    first1++;
+    uint8_t *bank_base;
+    int bank_start = 0;
+    int bank_limit = 0;
+    uint8_t bank_bank = 0;
+
     o_bank_base = &bank_base;
     o_bank_start = &bank_start;
     o_bank_limit = &bank_limit;
@@ -286,9 +282,8 @@ if(first1==0){
     reg_c = 0;
 
     machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
-}
 
-    /*while (1)*/ {
+    while (1) {
 
 #define CLK maincpu_clk
 #define LAST_OPCODE_INFO last_opcode_info
@@ -358,12 +353,15 @@ if(first1==0){
 #endif
     }
 }
-#endif
 
-void maincpu_mainloop(void)
+#ifdef __LIBRETRO__
+/* Like maincpu_mainloop(), but returns once vsyncarch_presync() has cleared
+   cpuloop at the end of the frame, after at least one opcode.  Between two
+   calls the registers are in maincpu_regs, where snapshots read and write
+   them.  IMPORT_REGISTERS() and EXPORT_REGISTERS() come with the CPU core
+   included above.  */
+void maincpu_mainloop_retro(void)
 {
-    /* Notice that using a struct for these would make it a lot slower (at
-       least, on gcc 2.7.2.x).  */
  union regs {
      uint16_t reg_s;
      uint8_t reg_q[2];
@@ -388,7 +386,7 @@ void maincpu_mainloop(void)
     uint8_t flag_n = 0;
     uint8_t flag_z = 0;
     uint8_t reg_emul = 1;
-    int interrupt65816 = IK_RESET;
+    static int interrupt65816 = IK_RESET;
 #ifndef NEED_REG_PC
     unsigned int reg_pc;
 #endif
@@ -396,6 +394,7 @@ void maincpu_mainloop(void)
     int bank_start = 0;
     int bank_limit = 0;
     uint8_t bank_bank = 0;
+    static int first1 = 0;
 
     o_bank_base = &bank_base;
     o_bank_start = &bank_start;
@@ -404,9 +403,14 @@ void maincpu_mainloop(void)
 
     reg_c = 0;
 
-    machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    if (first1 == 0) {
+        first1++;
+        machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    } else {
+        IMPORT_REGISTERS();
+    }
 
-    while (1) {
+    do {
 
 #define CLK maincpu_clk
 #define LAST_OPCODE_INFO last_opcode_info
@@ -474,8 +478,16 @@ void maincpu_mainloop(void)
         if (CLK > 246171754)
             debug.maincpu_traceflg = 1;
 #endif
-    }
+    } while (cpuloop > 0);
+
+    EXPORT_REGISTERS();
+
+    o_bank_base = NULL;
+    o_bank_start = NULL;
+    o_bank_limit = NULL;
+    o_bank_bank = NULL;
 }
+#endif
 
 /* ------------------------------------------------------------------------- */
 
@@ -550,37 +550,32 @@ void maincpu_resync_limits(void)
     }
 }
 
-#ifdef __LIBRETRO__
-void maincpu_mainloop_retro(void)
+void maincpu_mainloop(void)
 {
     /* Notice that using a struct for these would make it a lot slower (at
        least, on gcc 2.7.2.x).  */
-static    uint8_t reg_a = 0;
-static    uint8_t reg_x = 0;
-static    uint8_t reg_y = 0;
-static    uint8_t reg_p = 0;
-static    uint8_t reg_sp = 0;
-static    uint8_t flag_n = 0;
-static    uint8_t flag_z = 0;
+    uint8_t reg_a = 0;
+    uint8_t reg_x = 0;
+    uint8_t reg_y = 0;
+    uint8_t reg_p = 0;
+    uint8_t reg_sp = 0;
+    uint8_t flag_n = 0;
+    uint8_t flag_z = 0;
 #ifndef NEED_REG_PC
     /* FIXME: this should really be uint16_t, but it breaks things (eg trap17.prg) */
-static    unsigned int reg_pc;
+    unsigned int reg_pc;
 #endif
-static    uint8_t *bank_base;
-static    int bank_start = 0;
-static    int bank_limit = 0;
+    uint8_t *bank_base;
+    int bank_start = 0;
+    int bank_limit = 0;
 
-static int first1=0;
-if(first1==0){
-    first1++;
     o_bank_base = &bank_base;
     o_bank_start = &bank_start;
     o_bank_limit = &bank_limit;
 
     machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
-}
 
-    /*while (1)*/ {
+    while (1) {
 #define CLK maincpu_clk
 #define RMW_FLAG maincpu_rmw_flag
 #define LAST_OPCODE_INFO last_opcode_info
@@ -643,13 +638,15 @@ if(first1==0){
 #endif
     }
 }
-#endif
-
 
-void maincpu_mainloop(void)
+#ifdef __LIBRETRO__
+/* Like maincpu_mainloop(), but returns once vsyncarch_presync() has cleared
+   cpuloop at the end of the frame, after at least one opcode.  Between two
+   calls the registers are in maincpu_regs, where snapshots read and write
+   them.  IMPORT_REGISTERS() and EXPORT_REGISTERS() come with the CPU core
+   included above.  */
+void maincpu_mainloop_retro(void)
 {
-    /* Notice that using a struct for these would make it a lot slower (at
-       least, on gcc 2.7.2.x).  */
     uint8_t reg_a = 0;
     uint8_t reg_x = 0;
     uint8_t reg_y = 0;
@@ -664,14 +661,20 @@ void maincpu_mainloop(void)
     uint8_t *bank_base;
     int bank_start = 0;
     int bank_limit = 0;
+    static int first1 = 0;
 
     o_bank_base = &bank_base;
     o_bank_start = &bank_start;
     o_bank_limit = &bank_limit;
 
-    machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    if (first1 == 0) {
+        first1++;
+        machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    } else {
+        IMPORT_REGISTERS();
+    }
 
-    while (1) {
+    do {
 #define CLK maincpu_clk
 #define RMW_FLAG maincpu_rmw_flag
 #define LAST_OPCODE_INFO last_opcode_info
@@ -732,8 +735,15 @@ void maincpu_mainloop(void)
             debug.maincpu_traceflg = 1;
         }
 #endif
-    }
+    } while (cpuloop > 0);
+
+    EXPORT_REGISTERS();
+
+    o_bank_base = NULL;
+    o_bank_start = NULL;
+    o_bank_limit = NULL;
 }
+#endif
 
 /* ------------------------------------------------------------------------- */
 
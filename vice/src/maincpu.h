@@ -89,6 +89,11 @@ extern void maincpu_early_init(void);
 extern void maincpu_shutdown(void);
 extern void maincpu_reset(void);
 extern void maincpu_mainloop(void);
+#ifdef __LIBRETRO__
+/* Cleared by vsyncarch_presync() to end maincpu_mainloop_retro() */
+extern int cpuloop;
+extern void maincpu_mainloop_retro(void);
+#endif
 extern struct monitor_interface_s *maincpu_monitor_interface_get(void);
 extern int maincpu_snapshot_read_module(struct snapshot_s *s);
 extern int maincpu_snapshot_write_module(struct snapshot_s *s);
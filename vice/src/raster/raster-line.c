@@ -43,6 +43,13 @@
 #include "raster.h"
 #include "viewport.h"
 
+#ifdef __LIBRETRO__
+#include "retro_perf.h"
+#else
+#define RETRO_PERF_BEGIN(id)
+#define RETRO_PERF_END(id)
+#endif
+
 
 unsigned int raster_line_get_real_mode(raster_t *raster)
 {
@@ -105,6 +112,30 @@ inline static int map_current_line_to_area(raster_t *raster)
             : raster->current_line);
 }
 
+/* Lines of skipped frames are not drawn, unless sprites are displayed on
+   them because the collisions are found while drawing.  The draw buffer
+   and the cache keep the line as it was last drawn, so this is not done
+   while the cache is being refilled.  */
+inline static int skip_line(raster_t *raster)
+{
+    return raster->skip_frame
+           && !raster->dont_cache
+           && (raster->sprite_status == NULL
+               || !(raster->sprite_status->dma_msk
+                    || raster->sprite_status->new_dma_msk));
+}
+
+inline static void handle_skipped_line(raster_t *raster)
+{
+    if (raster->changes->have_on_this_line) {
+        raster_changes_apply_all(raster->changes->background);
+        raster_changes_apply_all(raster->changes->foreground);
+        raster_changes_apply_all(raster->changes->border);
+        raster_changes_apply_all(raster->changes->sprites);
+        raster->changes->have_on_this_line = 0;
+    }
+}
+
 inline static void handle_blank_line_cached(raster_t *raster)
 {
     if (raster->dont_cache
@@ -129,6 +160,11 @@ inline static void handle_blank_line_cached(raster_t *raster)
 
 static void handle_blank_line(raster_t *raster)
 {
+    if (skip_line(raster)) {
+        handle_skipped_line(raster);
+        return;
+    }
+
     if (raster->changes->have_on_this_line) {
         raster_changes_t *border_changes;
         unsigned int i, xs;
@@ -631,7 +667,9 @@ static void handle_visible_line_with_changes(raster_t *raster)
 
 inline static void handle_visible_line(raster_t *raster)
 {
-    if (raster->changes->have_on_this_line) {
+    if (skip_line(raster)) {
+        handle_skipped_line(raster);
+    } else if (raster->changes->have_on_this_line) {
         handle_visible_line_with_changes(raster);
     } else {
         if (raster->cache_enabled
@@ -650,6 +688,10 @@ inline static void handle_visible_line(raster_t *raster)
 
 void raster_line_emulate(raster_t *raster)
 {
+    if (!raster->threaded) {
+        RETRO_PERF_BEGIN(RETRO_PERF_RASTER);
+    }
+
     raster_draw_buffer_ptr_update(raster);
 
     /* Emulate the vertical blank flip-flops.  (Well, sort of.)  */
@@ -735,4 +777,8 @@ void raster_line_emulate(raster_t *raster)
     }
 
     raster->blank_this_line = 0;
+
+    if (!raster->threaded) {
+        RETRO_PERF_END(RETRO_PERF_RASTER);
+    }
 }
@@ -184,6 +184,9 @@ struct raster_s {
                              unsigned int *, unsigned int *);
 
     int intialized;
+
+    /* Drawn on a worker thread, which is not timed by the raster.  */
+    int threaded;
 };
 typedef struct raster_s raster_t;
 
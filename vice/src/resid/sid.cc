@@ -27,6 +27,17 @@
 #include "sid.h"
 #include <math.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define RESID_CONVOLVE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define RESID_CONVOLVE_NEON
+#include <arm_neon.h>
+#endif
+
 #ifndef round
 #define round(x) (x>=0.0?floor(x+0.5):ceil(x-0.5))
 #endif
@@ -756,6 +767,67 @@ void SID::clock(cycle_count delta_t)
 }
 
 
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t cycles without audio sampling.
+//
+// The sampling state is kept where clocking with audio sampling would
+// leave it: the sample offset is advanced over the samples that are not
+// generated, and the cycles read back by the next samples are clocked one
+// at a time into the interpolation or resampling history. Audio sampling
+// can thus be resumed without convolving stale samples.
+// ----------------------------------------------------------------------------
+void SID::clock_silent(cycle_count delta_t)
+{
+  const cycle_count offset = sampling == SAMPLE_FAST ? 1 << (FIXP_SHIFT - 1) : 0;
+  cycle_count delta_t_history;
+
+  for (cycle_count t = delta_t; ; ) {
+    cycle_count next_sample_offset = sample_offset + cycles_per_sample + offset;
+    cycle_count delta_t_sample = next_sample_offset >> FIXP_SHIFT;
+
+    if (delta_t_sample >= t) {
+      sample_offset -= t << FIXP_SHIFT;
+      break;
+    }
+
+    t -= delta_t_sample;
+    sample_offset = (next_sample_offset & FIXP_MASK) - offset;
+  }
+
+  switch (sampling) {
+  default:
+  case SAMPLE_FAST:
+    delta_t_history = 0;
+    break;
+  case SAMPLE_INTERPOLATE:
+    delta_t_history = 2;
+    break;
+  case SAMPLE_RESAMPLE:
+  case SAMPLE_RESAMPLE_FASTMEM:
+    delta_t_history = fir_N + 1;
+    break;
+  }
+
+  if (delta_t_history > delta_t) {
+    delta_t_history = delta_t;
+  }
+
+  clock(delta_t - delta_t_history);
+
+  for (int i = delta_t_history; i > 0; i--) {
+    clock();
+    if (sampling == SAMPLE_INTERPOLATE) {
+      sample_prev = sample_now;
+      sample_now = output();
+    }
+    else {
+      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
+      ++sample_index &= RINGMASK;
+    }
+  }
+}
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling.
 // Fixed point arithmetics are used.
@@ -860,6 +932,106 @@ int SID::clock_interpolate(cycle_count& delta_t, short* buf, int n, int interlea
 }
 
 
+// ----------------------------------------------------------------------------
+// Convolution of samples with a FIR table.
+// The SIMD versions add up the products in 32 bit lanes. Integer addition
+// wraps around the same way in any order, so the sum is exactly that of
+// the plain loop.
+// ----------------------------------------------------------------------------
+typedef int (*convolve_t)(const short* a, const short* b, int n);
+
+static int convolve_c(const short* a, const short* b, int n)
+{
+  int v = 0;
+
+  for (int i = 0; i < n; i++) {
+    v += a[i]*b[i];
+  }
+
+  return v;
+}
+
+#ifdef RESID_CONVOLVE_X86
+__attribute__((target("sse2")))
+static int convolve_sse2(const short* a, const short* b, int n)
+{
+  __m128i acc = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(x, y));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  return _mm_cvtsi128_si32(acc) + convolve_c(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int convolve_avx2(const short* a, const short* b, int n)
+{
+  __m256i acc = _mm256_setzero_si256();
+  __m128i sum;
+  int i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+  }
+  sum = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                      _mm256_extracti128_si256(acc, 1));
+  if (i + 8 <= n) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(x, y));
+    i += 8;
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  return _mm_cvtsi128_si32(sum) + convolve_c(a + i, b + i, n - i);
+}
+#endif
+
+#ifdef RESID_CONVOLVE_NEON
+static int convolve_neon(const short* a, const short* b, int n)
+{
+  int32x4_t acc = vdupq_n_s32(0);
+  int i;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    int16x8_t x = vld1q_s16(a + i);
+    int16x8_t y = vld1q_s16(b + i);
+    acc = vmlal_s16(acc, vget_low_s16(x), vget_low_s16(y));
+    acc = vmlal_high_s16(acc, x, y);
+  }
+
+  return vaddvq_s32(acc) + convolve_c(a + i, b + i, n - i);
+}
+#endif
+
+static convolve_t convolve_select()
+{
+#if defined(RESID_CONVOLVE_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return convolve_avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return convolve_sse2;
+  }
+#elif defined(RESID_CONVOLVE_NEON)
+  return convolve_neon;
+#endif
+  return convolve_c;
+}
+
+static const convolve_t convolve = convolve_select();
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling - cycle based with audio resampling.
 //
@@ -927,10 +1099,7 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
     short* sample_start = sample + sample_index - fir_N - 1 + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v1 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v1 += sample_start[j]*fir_start[j];
-    }
+    int v1 = convolve(sample_start, fir_start, fir_N);
 
     // Use next FIR table, wrap around to first FIR table using
     // next sample.
@@ -941,10 +1110,7 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
     fir_start = fir + fir_offset*fir_N;
 
     // Convolution with filter impulse response.
-    int v2 = 0;
-    for (int k = 0; k < fir_N; k++) {
-      v2 += sample_start[k]*fir_start[k];
-    }
+    int v2 = convolve(sample_start, fir_start, fir_N);
 
     // Linear interpolation.
     // fir_offset_rmd is equal for all samples, it can thus be factorized out:
@@ -1002,10 +1168,7 @@ int SID::clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int int
     short* sample_start = sample + sample_index - fir_N + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v += sample_start[j]*fir_start[j];
-    }
+    int v = convolve(sample_start, fir_start, fir_N);
 
     v >>= FIR_SHIFT;
 
@@ -54,6 +54,7 @@ public:
   void clock();
   void clock(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
+  void clock_silent(cycle_count delta_t);
   void reset();
 
   // Read/write registers.
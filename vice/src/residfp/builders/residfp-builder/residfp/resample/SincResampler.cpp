@@ -38,11 +38,26 @@
 #  include "config.h"
 #endif
 
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  define CONVOLVE_X86
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  define CONVOLVE_NEON
+#endif
+
 #ifdef __LIBRETRO__
 #else
 #ifdef HAVE_MMINTRIN_H
 #  include <mmintrin.h>
 #endif
+#ifdef CONVOLVE_X86
+#  include <immintrin.h>
+#endif
+#ifdef CONVOLVE_NEON
+#  include <arm_neon.h>
+#endif
 #endif
 
 namespace reSIDfp
@@ -85,15 +100,9 @@ double I0(double x)
     return sum;
 }
 
-/**
- * Calculate convolution with sample and sinc.
- *
- * @param a sample buffer input
- * @param b sinc buffer
- * @param bLength length of the sinc buffer
- * @return convolved result
- */
-int convolve(const short* a, const short* b, int bLength)
+typedef int (*convolve_t)(const short* a, const short* b, int bLength);
+
+int convolve_generic(const short* a, const short* b, int bLength)
 {
 #ifdef HAVE_MMINTRIN_H
     __m64 acc = _mm_setzero_si64();
@@ -103,7 +112,7 @@ int convolve(const short* a, const short* b, int bLength)
     for (int i = 0; i < n; i++)
     {
         const __m64 tmp = _mm_madd_pi16(*(__m64*)a, *(__m64*)b);
-        acc = _mm_add_pi16(acc, tmp);
+        acc = _mm_add_pi32(acc, tmp);
         a += 4;
         b += 4;
     }
@@ -121,7 +130,133 @@ int convolve(const short* a, const short* b, int bLength)
         out += *a++ * *b++;
     }
 
-    return (out + (1 << 14)) >> 15;
+    return out;
+}
+
+/*
+ * The SIMD versions add up the products in 32 bit lanes. Integer addition
+ * wraps around the same way in any order, so the sum is exactly that of
+ * the plain loop.
+ */
+#ifdef CONVOLVE_X86
+__attribute__((target("sse2")))
+int convolve_sse2(const short* a, const short* b, int bLength)
+{
+    __m128i acc = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i + 8 <= bLength; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        const __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(x, y));
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    int out = _mm_cvtsi128_si32(acc);
+
+    for (; i < bLength; i++)
+    {
+        out += a[i] * b[i];
+    }
+
+    return out;
+}
+
+__attribute__((target("avx2")))
+int convolve_avx2(const short* a, const short* b, int bLength)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i + 16 <= bLength; i += 16)
+    {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        const __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+    }
+
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+
+    if (i + 8 <= bLength)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        const __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(x, y));
+        i += 8;
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    int out = _mm_cvtsi128_si32(sum);
+
+    for (; i < bLength; i++)
+    {
+        out += a[i] * b[i];
+    }
+
+    return out;
+}
+#endif
+
+#ifdef CONVOLVE_NEON
+int convolve_neon(const short* a, const short* b, int bLength)
+{
+    int32x4_t acc = vdupq_n_s32(0);
+    int i;
+
+    for (i = 0; i + 8 <= bLength; i += 8)
+    {
+        const int16x8_t x = vld1q_s16(a + i);
+        const int16x8_t y = vld1q_s16(b + i);
+        acc = vmlal_s16(acc, vget_low_s16(x), vget_low_s16(y));
+        acc = vmlal_high_s16(acc, x, y);
+    }
+
+    int out = vaddvq_s32(acc);
+
+    for (; i < bLength; i++)
+    {
+        out += a[i] * b[i];
+    }
+
+    return out;
+}
+#endif
+
+convolve_t convolve_select()
+{
+#if defined(CONVOLVE_X86)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return convolve_avx2;
+
+    if (__builtin_cpu_supports("sse2"))
+        return convolve_sse2;
+#elif defined(CONVOLVE_NEON)
+    return convolve_neon;
+#endif
+
+    return convolve_generic;
+}
+
+const convolve_t convolve_kernel = convolve_select();
+
+/**
+ * Calculate convolution with sample and sinc.
+ *
+ * @param a sample buffer input
+ * @param b sinc buffer
+ * @param bLength length of the sinc buffer
+ * @return convolved result
+ */
+int convolve(const short* a, const short* b, int bLength)
+{
+    return (convolve_kernel(a, b, bLength) + (1 << 14)) >> 15;
 }
 
 int SincResampler::fir(int subcycle)
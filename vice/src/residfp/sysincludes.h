@@ -16,6 +16,13 @@
 #ifdef HAVE_MMINTRIN_H
 #  include <mmintrin.h>
 #endif
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#endif
 #ifdef __QNX__
 #include <math.h>
 #include <string.h>
@@ -1,5 +1,13 @@
 #include <math.h>
 
+/* The intrinsics sid.cc uses for the resampler, which must not end up in the
+   namespace below */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /* Compile ReSID to its own namespace to avoid symbol clashes with the original one, but enable new filters
 this time. */
 #define NEW_8580_FILTER 1
@@ -277,6 +277,13 @@ static int resid_calculate_samples(sound_t *psid, short *pbuf, int nr,
     short *tmp_buf;
     int retval;
 
+    /* Nobody listens, keep the chip in step but skip the resampling.  */
+    if (sound_get_discard_output()) {
+        psid->sid->clock_silent(*delta_t);
+        *delta_t = 0;
+        return 0;
+    }
+
     if (psid->factor == 1000) {
         return psid->sid->clock(*delta_t, pbuf, nr, interleave);
     }
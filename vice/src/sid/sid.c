@@ -54,6 +54,10 @@
 #include "lightpen.h"
 #endif
 
+#ifdef HAVE_THREADS
+#include "rthreads/rthreads.h"
+#endif
+
 #ifdef HAVE_RESID
 #include "resid.h"
 #ifdef __LIBRETRO__
@@ -415,6 +419,178 @@ static int16_t *getbuf3(int len)
 }
 
 
+/* ------------------------------------------------------------------------- */
+
+/* Parallel synthesis of the SID chips: each chip is clocked through the
+   writes queued since the last call on its own, then the results are mixed
+   the same way as above.  */
+
+/* Below this many cycles the chips are not worth handing to the workers.  */
+#define SID_PARALLEL_MIN_CYCLES 1000
+
+typedef struct sid_job_s {
+    sound_t *psid;
+    int chipno;
+    int16_t *buf;
+    int nr;
+    int delta_t;
+    const sound_store_t *stores;
+    int num_stores;
+    int result;
+} sid_job_t;
+
+static int16_t *chipbuf[SOUND_SIDS_MAX];
+static int chipblen[SOUND_SIDS_MAX];
+
+static int16_t *getchipbuf(int chipno, int len)
+{
+    if (chipbuf[chipno] != NULL) {
+        if (chipblen[chipno] >= len) {
+            /* large enough */
+            return chipbuf[chipno];
+        }
+        lib_free(chipbuf[chipno]);
+    }
+    chipbuf[chipno] = lib_calloc(len, sizeof(int16_t));
+    chipblen[chipno] = len;
+    return chipbuf[chipno];
+}
+
+static void sid_run_job(sid_job_t *job)
+{
+    int i, nr = 0, delta_t;
+    CLOCK done = 0;
+
+    for (i = 0; i < job->num_stores; i++) {
+        const sound_store_t *store = &job->stores[i];
+
+        /* Stop at the writes to the other chips as well, so the chip is
+           clocked in the same steps as without the queue.  */
+        if (store->offset != done) {
+            delta_t = (int)(store->offset - done);
+            nr += sid_engine.calculate_samples(job->psid, job->buf + nr, job->nr - nr, 1, &delta_t);
+            done = store->offset;
+        }
+        if (store->chipno == job->chipno) {
+            sid_engine.store(job->psid, store->addr, store->val);
+        }
+    }
+
+    delta_t = job->delta_t - (int)done;
+    nr += sid_engine.calculate_samples(job->psid, job->buf + nr, job->nr - nr, 1, &delta_t);
+
+    job->delta_t = delta_t;
+    job->result = nr;
+}
+
+#ifdef HAVE_THREADS
+typedef struct sid_worker_s {
+    sthread_t *thread;
+    slock_t *lock;
+    scond_t *cond;
+    sid_job_t *job;     /* job to run, NULL when done */
+    int quit;
+} sid_worker_t;
+
+/* Chip 0 is synthesized by the emulation thread itself.  */
+static sid_worker_t sid_workers[SOUND_SIDS_MAX];
+
+static void sid_worker_thread(void *data)
+{
+    sid_worker_t *worker = (sid_worker_t *)data;
+
+    slock_lock(worker->lock);
+    for (;;) {
+        while (!worker->job && !worker->quit) {
+            scond_wait(worker->cond, worker->lock);
+        }
+        if (worker->quit) {
+            break;
+        }
+        slock_unlock(worker->lock);
+
+        sid_run_job(worker->job);
+
+        slock_lock(worker->lock);
+        worker->job = NULL;
+        scond_signal(worker->cond);
+    }
+    slock_unlock(worker->lock);
+}
+
+static void sid_workers_stop(void)
+{
+    int i;
+
+    for (i = 1; i < SOUND_SIDS_MAX; i++) {
+        sid_worker_t *worker = &sid_workers[i];
+
+        if (!worker->thread) {
+            continue;
+        }
+        slock_lock(worker->lock);
+        worker->quit = 1;
+        scond_signal(worker->cond);
+        slock_unlock(worker->lock);
+        sthread_join(worker->thread);
+
+        scond_free(worker->cond);
+        slock_free(worker->lock);
+        memset(worker, 0, sizeof(*worker));
+    }
+}
+
+static int sid_workers_start(int scc)
+{
+    int i;
+
+    for (i = 1; i < scc; i++) {
+        sid_worker_t *worker = &sid_workers[i];
+
+        if (worker->thread) {
+            continue;
+        }
+        worker->lock = slock_new();
+        worker->cond = scond_new();
+        worker->job = NULL;
+        worker->quit = 0;
+        if (!worker->lock || !worker->cond
+            || !(worker->thread = sthread_create(sid_worker_thread, worker))) {
+            if (worker->cond) {
+                scond_free(worker->cond);
+            }
+            if (worker->lock) {
+                slock_free(worker->lock);
+            }
+            memset(worker, 0, sizeof(*worker));
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void sid_worker_post(int chipno, sid_job_t *job)
+{
+    sid_worker_t *worker = &sid_workers[chipno];
+
+    slock_lock(worker->lock);
+    worker->job = job;
+    scond_signal(worker->cond);
+    slock_unlock(worker->lock);
+}
+
+static void sid_worker_wait(int chipno)
+{
+    sid_worker_t *worker = &sid_workers[chipno];
+
+    slock_lock(worker->lock);
+    while (worker->job) {
+        scond_wait(worker->cond, worker->lock);
+    }
+    slock_unlock(worker->lock);
+}
+#endif
+
 int sid_sound_machine_init_vbr(sound_t *psid, int speed, int cycles_per_sec, int factor)
 {
     return sid_engine.init(psid, speed * factor / 1000, cycles_per_sec, factor);
@@ -427,6 +603,8 @@ int sid_sound_machine_init(sound_t *psid, int speed, int cycles_per_sec)
 
 void sid_sound_machine_close(sound_t *psid)
 {
+    int i;
+
     sid_engine.close(psid);
     /* free the temp. buffers */
     if (buf1) {
@@ -444,6 +622,16 @@ void sid_sound_machine_close(sound_t *psid)
         blen3 = 0;
         buf3 = NULL;
     }
+#ifdef HAVE_THREADS
+    sid_workers_stop();
+#endif
+    for (i = 0; i < SOUND_SIDS_MAX; i++) {
+        if (chipbuf[i]) {
+            lib_free(chipbuf[i]);
+            chipblen[i] = 0;
+            chipbuf[i] = NULL;
+        }
+    }
 }
 
 uint8_t sid_sound_machine_read(sound_t *psid, uint16_t addr)
@@ -551,6 +739,70 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     return tmp_nr;
 }
 
+int sid_sound_machine_calculate_samples_queued(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, int *delta_t, const sound_store_t *stores, int num_stores)
+{
+    sid_job_t jobs[SOUND_SIDS_MAX];
+    int16_t *b[SOUND_SIDS_MAX];
+    int i, c, last;
+
+    for (c = 0; c < scc; c++) {
+        jobs[c].psid = psid[c];
+        jobs[c].chipno = c;
+        jobs[c].buf = b[c] = getchipbuf(c, nr);
+        jobs[c].nr = nr;
+        jobs[c].delta_t = *delta_t;
+        jobs[c].stores = stores;
+        jobs[c].num_stores = num_stores;
+    }
+
+#ifdef HAVE_THREADS
+    if (scc > 1 && *delta_t >= SID_PARALLEL_MIN_CYCLES && sid_workers_start(scc)) {
+        for (c = 1; c < scc; c++) {
+            sid_worker_post(c, &jobs[c]);
+        }
+        sid_run_job(&jobs[0]);
+        for (c = 1; c < scc; c++) {
+            sid_worker_wait(c);
+        }
+    } else
+#endif
+    {
+        for (c = 0; c < scc; c++) {
+            sid_run_job(&jobs[c]);
+        }
+    }
+
+    /* The second chip is the one calculated last above.  */
+    last = (scc > 1) ? 1 : 0;
+    nr = jobs[last].result;
+    *delta_t = jobs[last].delta_t;
+
+    if (soc == 1) {
+        for (i = 0; i < nr; i++) {
+            pbuf[i] = b[last][i];
+            if (scc > 1) {
+                pbuf[i] = sound_audio_mix(pbuf[i], b[0][i]);
+            }
+            for (c = 2; c < scc; c++) {
+                pbuf[i] = sound_audio_mix(pbuf[i], b[c][i]);
+            }
+        }
+    } else {
+        for (i = 0; i < nr; i++) {
+            pbuf[i * 2] = b[0][i];
+            pbuf[(i * 2) + 1] = b[last][i];
+            if (scc == 3) {
+                pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], b[2][i]);
+                pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], b[2][i]);
+            } else if (scc == 4) {
+                pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], b[2][i]);
+                pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], b[3][i]);
+            }
+        }
+    }
+    return nr;
+}
+
 void sid_sound_machine_prevent_clk_overflow(sound_t *psid, CLOCK sub)
 {
     sid_engine.prevent_clk_overflow(psid, sub);
@@ -130,6 +130,28 @@ struct snapshot_memory_stream_s {
 
     /* Stream size */
     size_t stream_size;
+
+    /* Payloads left in the buffer by the previous snapshot, or NULL */
+    snapshot_memory_cache_t *cache;
+};
+
+/* Byte array written with a generation number into a memory buffer */
+typedef struct snapshot_cache_entry_s {
+    const uint8_t *data;
+    unsigned int num;
+    unsigned int generation;
+    long offset;
+} snapshot_cache_entry_t;
+
+#define SNAPSHOT_CACHE_ENTRIES 32
+
+/* The entries of the previous snapshot into the buffer are looked up, the
+   current snapshot records its own into the other set.  */
+struct snapshot_memory_cache_s {
+    void *buffer;
+    int current;
+    int count[2];
+    snapshot_cache_entry_t entries[2][SNAPSHOT_CACHE_ENTRIES];
 };
 
 struct snapshot_module_s {
@@ -429,6 +451,7 @@ snapshot_stream_t* snapshot_memory_write_fopen(void* buffer, size_t buffer_size)
     stream->buffer_size = buffer_size;
     stream->pointer = 0;
     stream->stream_size = 0;
+    stream->cache = NULL;
     stream->istream.ops = &snapshot_memory_ops;
     return &stream->istream;
 
@@ -436,6 +459,43 @@ fail:
     return NULL;
 }
 
+snapshot_stream_t* snapshot_memory_write_cached_fopen(void* buffer, size_t buffer_size, snapshot_memory_cache_t *cache)
+{
+    snapshot_stream_t* f = snapshot_memory_write_fopen(buffer, buffer_size);
+    snapshot_memory_stream_t* stream;
+
+    if (f == NULL || buffer == NULL) {
+        return f;
+    }
+
+    if (cache->buffer != buffer) {
+        snapshot_memory_cache_invalidate(cache);
+        cache->buffer = buffer;
+    }
+    cache->current ^= 1;
+    cache->count[cache->current] = 0;
+
+    stream = container_of(f, snapshot_memory_stream_t, istream);
+    stream->cache = cache;
+    return f;
+}
+
+snapshot_memory_cache_t *snapshot_memory_cache_new(void)
+{
+    return lib_calloc(1, sizeof(snapshot_memory_cache_t));
+}
+
+void snapshot_memory_cache_invalidate(snapshot_memory_cache_t *cache)
+{
+    cache->count[0] = 0;
+    cache->count[1] = 0;
+}
+
+void snapshot_memory_cache_free(snapshot_memory_cache_t *cache)
+{
+    lib_free(cache);
+}
+
 snapshot_stream_t* snapshot_memory_read_fopen(const void* buffer, size_t buffer_size)
 {
     snapshot_memory_stream_t* stream = lib_malloc(sizeof(snapshot_memory_stream_t));
@@ -448,6 +508,7 @@ snapshot_stream_t* snapshot_memory_read_fopen(const void* buffer, size_t buffer_
     stream->buffer_size = buffer_size;
     stream->pointer = 0;
     stream->stream_size = buffer_size;
+    stream->cache = NULL;
     stream->istream.ops = &snapshot_memory_ops;
     return &stream->istream;
 
@@ -800,6 +861,60 @@ int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *b, uns
     return 0;
 }
 
+/* Leave a byte array in place if the previous snapshot into the same buffer
+   wrote it at the same offset and with the same generation.  */
+static int snapshot_memory_write_generation(snapshot_stream_t* f, const uint8_t *data, unsigned int num, unsigned int generation)
+{
+    snapshot_memory_stream_t* stream = container_of(f, snapshot_memory_stream_t, istream);
+    snapshot_memory_cache_t *cache = stream->cache;
+    snapshot_cache_entry_t *e;
+    int previous = cache->current ^ 1;
+    int i;
+
+    for (i = 0; i < cache->count[previous]; i++) {
+        e = &cache->entries[previous][i];
+        if (e->offset == stream->pointer && e->data == data
+            && e->num == num && e->generation == generation) {
+            break;
+        }
+    }
+
+    if (i < cache->count[previous] && stream->pointer + num <= stream->buffer_size) {
+        stream->pointer += num;
+        if (stream->pointer > stream->stream_size) {
+            stream->stream_size = stream->pointer;
+        }
+    } else if (snapshot_write_byte_array(f, data, num) < 0) {
+        return -1;
+    }
+
+    if (cache->count[cache->current] < SNAPSHOT_CACHE_ENTRIES) {
+        e = &cache->entries[cache->current][cache->count[cache->current]++];
+        e->offset = stream->pointer - num;
+        e->data = data;
+        e->num = num;
+        e->generation = generation;
+    }
+    return 0;
+}
+
+/* Like snapshot_module_write_byte_array(), the generation must change
+   whenever the contents of the array do.  */
+int snapshot_module_write_byte_array_generation(snapshot_module_t *m, const uint8_t *b, unsigned int num, unsigned int generation)
+{
+    if (m->file->ops != &snapshot_memory_ops
+        || container_of(m->file, snapshot_memory_stream_t, istream)->cache == NULL) {
+        return snapshot_module_write_byte_array(m, b, num);
+    }
+
+    if (snapshot_memory_write_generation(m->file, b, num, generation) < 0) {
+        return -1;
+    }
+
+    m->size += num;
+    return 0;
+}
+
 int snapshot_module_write_word_array(snapshot_module_t *m, const uint16_t *w, unsigned int num)
 {
     if (snapshot_write_word_array(m->file, w, num) < 0) {
@@ -1032,6 +1147,13 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
             goto fail;
         }
 
+        /* A module is never smaller than its header, anything else is
+           the zero padding after the last module.  */
+        if (m->size < SNAPSHOT_MODULE_NAME_LEN + 2 + sizeof(uint32_t)) {
+            snapshot_error = SNAPSHOT_MODULE_NOT_FOUND_ERROR;
+            goto fail;
+        }
+
         /* Found?  */
         if (memcmp(n, name, name_len) == 0
             && (name_len == SNAPSHOT_MODULE_NAME_LEN || n[name_len] == 0)) {
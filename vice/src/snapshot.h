@@ -63,6 +63,7 @@
 typedef struct snapshot_module_s snapshot_module_t;
 typedef struct snapshot_s snapshot_t;
 typedef struct snapshot_stream_s snapshot_stream_t;
+typedef struct snapshot_memory_cache_s snapshot_memory_cache_t;
 
 extern void snapshot_display_error(void);
 
@@ -75,6 +76,8 @@ extern int snapshot_module_write_padded_string(snapshot_module_t *m,
                                                int len);
 extern int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *data,
                                             unsigned int num);
+extern int snapshot_module_write_byte_array_generation(snapshot_module_t *m, const uint8_t *data,
+                                                       unsigned int num, unsigned int generation);
 extern int snapshot_module_write_word_array(snapshot_module_t *m, const uint16_t *data,
                                             unsigned int num);
 extern int snapshot_module_write_dword_array(snapshot_module_t *m, const uint32_t *data,
@@ -110,6 +113,7 @@ extern int snapshot_module_read_dword_into_uint(snapshot_module_t *m,
 #define SMW_DB      snapshot_module_write_double
 #define SMW_PSTR    snapshot_module_write_padded_string
 #define SMW_BA      snapshot_module_write_byte_array
+#define SMW_BA_GEN  snapshot_module_write_byte_array_generation
 #define SMW_WA      snapshot_module_write_word_array
 #define SMW_DWA     snapshot_module_write_dword_array
 #define SMW_STR     snapshot_module_write_string
@@ -167,6 +171,15 @@ extern snapshot_stream_t* snapshot_file_write_fopen(const char* pathname);
 extern snapshot_stream_t* snapshot_memory_read_fopen(const void* buffer, size_t buffer_size);
 extern snapshot_stream_t* snapshot_memory_write_fopen(void* buffer, size_t buffer_size);
 
+/* Memory streams written with a cache skip generation tagged byte arrays
+   that are unchanged since the previous snapshot into the same buffer. The
+   cache must be invalidated whenever the buffer is modified otherwise.  */
+extern snapshot_stream_t* snapshot_memory_write_cached_fopen(void* buffer, size_t buffer_size,
+                                                             snapshot_memory_cache_t *cache);
+extern snapshot_memory_cache_t *snapshot_memory_cache_new(void);
+extern void snapshot_memory_cache_invalidate(snapshot_memory_cache_t *cache);
+extern void snapshot_memory_cache_free(snapshot_memory_cache_t *cache);
+
 extern size_t snapshot_read(snapshot_stream_t* f, void* ptr, size_t size);
 extern size_t snapshot_write(snapshot_stream_t* f, const void* ptr, size_t size);
 extern int snapshot_fseek(snapshot_stream_t *f, long offset, int whence);
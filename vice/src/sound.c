@@ -59,6 +59,13 @@
 #include "math.h"
 #include "ui.h"
 
+#ifdef __LIBRETRO__
+#include "retro_perf.h"
+#else
+#define RETRO_PERF_BEGIN(id)
+#define RETRO_PERF_END(id)
+#endif
+
 
 static log_t sound_log = LOG_ERR;
 
@@ -190,6 +197,14 @@ static uint16_t offset = 0;
 
 static sound_chip_t *sound_calls[20];
 
+/* Register writes of the first chip held back until the samples are
+   calculated, so that its channels can be synthesized in parallel.  */
+#define SOUND_STORES_MAX 0x1000
+
+static int parallel_synthesis_enabled = 0;
+static sound_store_t queued_stores[SOUND_STORES_MAX];
+static int num_queued_stores = 0;
+
 uint16_t sound_chip_register(sound_chip_t *chip)
 {
     assert(chip != NULL);
@@ -254,7 +269,11 @@ static int sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr
     int i;
     int temp;
 
-    if (sound_calls[0]->cycle_based() || (!sound_calls[0]->cycle_based() && sound_calls[0]->chip_enabled)) {
+    if (num_queued_stores > 0
+        || (parallel_synthesis_enabled && scc > 1 && sound_calls[0]->calculate_samples_queued)) {
+        temp = sound_calls[0]->calculate_samples_queued(psid, pbuf, nr, soc, scc, delta_t, queued_stores, num_queued_stores);
+        num_queued_stores = 0;
+    } else if (sound_calls[0]->cycle_based() || (!sound_calls[0]->cycle_based() && sound_calls[0]->chip_enabled)) {
         temp = sound_calls[0]->calculate_samples(psid, pbuf, nr, soc, scc, delta_t);
     } else {
         memset(pbuf, 0, nr * sizeof(int16_t) * soc); /* FIXME: see above */
@@ -686,6 +705,9 @@ static int speed_percent;
 /* Flag: Is warp mode enabled?  */
 static int warp_mode_enabled;
 
+/* Flag: Is the generated sound thrown away by the frontend?  */
+static int discard_output_enabled;
+
 typedef struct {
     /* Number of sound output channels */
     int sound_output_channels;
@@ -1170,6 +1192,7 @@ void sound_close(void)
     sid_close();
 
     snddata.prevused = snddata.prevfill = 0;
+    num_queued_stores = 0;
 
     sdev_open = FALSE;
     sound_state_changed = FALSE;
@@ -1185,7 +1208,7 @@ void sound_close(void)
 }
 
 /* run sid */
-static int sound_run_sound(void)
+static int sound_generate_samples(void)
 {
     int nr = 0, i;
     int delta_t = 0;
@@ -1265,6 +1288,18 @@ static int sound_run_sound(void)
     return 0;
 }
 
+/* run sid, accounted to the SID profiling counter */
+static int sound_run_sound(void)
+{
+    int retval;
+
+    RETRO_PERF_BEGIN(RETRO_PERF_SID);
+    retval = sound_generate_samples();
+    RETRO_PERF_END(RETRO_PERF_SID);
+
+    return retval;
+}
+
 /* reset sid */
 void sound_reset(void)
 {
@@ -1274,6 +1309,7 @@ void sound_reset(void)
     snddata.wclk = maincpu_clk;
     snddata.lastclk = maincpu_clk;
     snddata.bufptr = 0;         /* ugly hack! */
+    num_queued_stores = 0;
     for (c = 0; c < snddata.sound_chip_channels; c++) {
         if (snddata.psid[c]) {
             sound_machine_reset(snddata.psid[c], maincpu_clk);
@@ -1614,19 +1650,49 @@ int sound_read(uint16_t addr, int chipno)
     return sound_machine_read(snddata.psid[chipno], addr);
 }
 
+/* Queue a write to the first chip instead of calculating the samples up to
+   it right away, when its channels are synthesized in parallel.  */
+static int sound_queue_store(uint16_t addr, uint8_t val, int chipno)
+{
+    sound_store_t *store;
+
+    if (!parallel_synthesis_enabled
+        || !cycle_based
+        || !snddata.playdev
+        || !playback_enabled
+        || (suspend_time > 0 && disabletime)
+        || (addr >> 5) != 0
+        || !sound_calls[0]->calculate_samples_queued
+        || snddata.sound_chip_channels < 2
+        || chipno >= snddata.sound_chip_channels
+        || num_queued_stores == SOUND_STORES_MAX) {
+        return 0;
+    }
+
+    store = &queued_stores[num_queued_stores++];
+    store->offset = maincpu_clk - snddata.lastclk;
+    store->addr = addr;
+    store->val = val;
+    store->chipno = (uint8_t)chipno;
+
+    return 1;
+}
+
 void sound_store(uint16_t addr, uint8_t val, int chipno)
 {
     int i;
 
-    if (sound_run_sound()) {
-        return;
-    }
+    if (!sound_queue_store(addr, val, chipno)) {
+        if (sound_run_sound()) {
+            return;
+        }
 
-    if (chipno >= snddata.sound_chip_channels) {
-        return;
-    }
+        if (chipno >= snddata.sound_chip_channels) {
+            return;
+        }
 
-    sound_machine_store(snddata.psid[chipno], addr, val);
+        sound_machine_store(snddata.psid[chipno], addr, val);
+    }
 
     if (!snddata.playdev->dump) {
         return;
@@ -1662,6 +1728,24 @@ void sound_set_warp_mode(int value)
     }
 }
 
+/* While the output is discarded, engines that support it only clock the
+   chips and produce no samples.  Warp mode throws its samples away too.  */
+void sound_set_discard_output(int value)
+{
+    discard_output_enabled = value;
+}
+
+int sound_get_discard_output(void)
+{
+    return discard_output_enabled
+           || (warp_mode_enabled && snddata.recdev == NULL);
+}
+
+void sound_set_parallel_synthesis(int value)
+{
+    parallel_synthesis_enabled = value;
+}
+
 void sound_snapshot_prepare(void)
 {
     /* Update lastclk.  */
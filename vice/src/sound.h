@@ -167,6 +167,9 @@ extern int sound_open(void);
 extern void sound_close(void);
 extern void sound_set_relative_speed(int value);
 extern void sound_set_warp_mode(int value);
+extern void sound_set_discard_output(int value);
+extern int sound_get_discard_output(void);
+extern void sound_set_parallel_synthesis(int value);
 extern void sound_set_machine_parameter(long clock_rate, long ticks_per_frame);
 extern void sound_snapshot_prepare(void);
 extern void sound_snapshot_finish(void);
@@ -236,6 +239,15 @@ extern const char *sound_device_name(unsigned int num);
 
 extern sound_t *sound_get_psid(unsigned int channel);
 
+/* A register write held back until the samples up to it are calculated.  */
+typedef struct sound_store_s {
+    /* Cycles since the samples were last calculated.  */
+    CLOCK offset;
+    uint16_t addr;
+    uint8_t val;
+    uint8_t chipno;
+} sound_store_t;
+
 typedef struct sound_chip_s {
     sound_t *(*open)(int chipno);
     int (*init)(sound_t *psid, int speed, int cycles_per_sec);
@@ -247,6 +259,9 @@ typedef struct sound_chip_s {
     int (*cycle_based)(void);
     int (*channels)(void);
     int chip_enabled;
+    /* Optional, calculates the samples of all chip channels applying the
+       queued register writes on the way, see sound_set_parallel_synthesis().  */
+    int (*calculate_samples_queued)(sound_t **psid, int16_t *pbuf, int nr, int sound_output_channels, int sound_chip_channels, int *delta_t, const sound_store_t *stores, int num_stores);
 } sound_chip_t;
 
 extern uint16_t sound_chip_register(sound_chip_t *chip);
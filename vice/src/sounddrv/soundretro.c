@@ -7,25 +7,49 @@
 
 #include <stdio.h>
 
+#include "lib.h"
 #include "sound.h"
 
-extern void retro_audio_render(signed short int *sound_buffer, int sndbufsize);
+extern void retro_audio_render(const int16_t *sound_buffer, size_t frames);
 extern int RETROSOUNDSAMPLERATE;
 
+/* Number of channels VICE delivers, 2 with stereo SID setups */
+static int retro_channels = 1;
+
+/* Interleaved stereo staging buffer, reused between fragments */
+static int16_t *retro_buffer = NULL;
+static size_t retro_buffer_frames = 0;
+
 static int retro_sound_init(const char *param, int *speed, int *fragsize, int *fragnr, int *channels)
 {
     *speed = RETROSOUNDSAMPLERATE;
     //*fragsize = 32;
     *fragnr = 0;
-    //*channels = 1;
+    retro_channels = *channels;
     //printf("speed:%d fragsize:%d fragnr:%d channels:%d\n", *speed, *fragsize, *fragnr, *channels);
     return 0;
 }
 
 static int retro_write(SWORD *pbuf, size_t nr)
 {
-    //printf("pbuf:%d nr:%d\n", *pbuf, nr);
-    retro_audio_render(pbuf, nr);
+    size_t frames = nr / retro_channels;
+    size_t i;
+
+    if (retro_channels == 2) {
+        retro_audio_render(pbuf, frames);
+        return 0;
+    }
+
+    if (frames > retro_buffer_frames) {
+        retro_buffer = lib_realloc(retro_buffer, frames * 2 * sizeof(int16_t));
+        retro_buffer_frames = frames;
+    }
+
+    /* Frontend always expects stereo, duplicate the mono samples */
+    for (i = 0; i < frames; i++) {
+        retro_buffer[i * 2] = retro_buffer[i * 2 + 1] = pbuf[i];
+    }
+    retro_audio_render(retro_buffer, frames);
     return 0;
 }
 
@@ -35,6 +59,13 @@ static int retro_flush(char *state)
     return 0;
 }
 
+static void retro_close(void)
+{
+    lib_free(retro_buffer);
+    retro_buffer = NULL;
+    retro_buffer_frames = 0;
+}
+
 static sound_device_t retro_device =
 {
     "retro",
@@ -43,11 +74,11 @@ static sound_device_t retro_device =
     NULL,
     retro_flush,
     NULL,
-    NULL,
+    retro_close,
     NULL,
     NULL,
     0,
-    1
+    2
 };
 
 int sound_init_retro_device(void)
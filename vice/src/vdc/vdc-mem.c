@@ -65,7 +65,7 @@ static void vdc_write_data(void)
     ptr = (vdc.regs[18] << 8) + vdc.regs[19];
 
     /* Write data byte to update address. */
-    vdc.ram[ptr & vdc.vdc_address_mask] = vdc.regs[31];
+    vdc_ram_write(ptr & vdc.vdc_address_mask, vdc.regs[31]);
 #ifdef REG_DEBUG
     log_message(vdc.log, "STORE %04x %02x", ptr & vdc.vdc_address_mask,
                 vdc.regs[31]);
@@ -92,8 +92,8 @@ static void vdc_perform_fillcopy(void)
         /* Block start address.  */
         ptr2 = (vdc.regs[32] << 8) + vdc.regs[33];
         for (i = 0; i < blklen; i++) {
-            vdc.ram[(ptr + i) & vdc.vdc_address_mask]
-                = vdc.ram[(ptr2 + i) & vdc.vdc_address_mask];
+            vdc_ram_write((ptr + i) & vdc.vdc_address_mask,
+                          vdc.ram[(ptr2 + i) & vdc.vdc_address_mask]);
         }
         ptr2 += blklen;
         vdc.regs[31] = vdc.ram[(ptr2 - 1) & vdc.vdc_address_mask];
@@ -105,7 +105,7 @@ static void vdc_perform_fillcopy(void)
                     ptr, blklen, vdc.regs[31]);
 #endif
         for (i = 0; i < blklen; i++) {
-            vdc.ram[(ptr + i) & vdc.vdc_address_mask] = vdc.regs[31];
+            vdc_ram_write((ptr + i) & vdc.vdc_address_mask, vdc.regs[31]);
         }
     }
 
@@ -164,7 +164,7 @@ void vdc_store(uint16_t addr, uint8_t value)
         default:
             log_message(vdc.log, "REG %02i VAL %02x CRL:%03i BH:%03i 0:%02X 1:%02X 2:%02X 3:%02X 4:%02X 5:%02X 6:%02X 7:%02X 8:%01X 9:%02X 12:%02X 13:%02X 20:%02X 21:%02X 22:%02X 23:%02X 24:%02X 25:%02X 26:%02X 27:%02X 34:%02X 35:%02X",
                         vdc.update_reg, value,
-                        vdc.raster.current_line, vdc.border_height,
+                        vdc.current_line, vdc.border_height,
                         vdc.regs[0], vdc.regs[1], vdc.regs[2], vdc.regs[3],
                         vdc.regs[4], (vdc.regs[5] & 0x1f), vdc.regs[6], vdc.regs[7],
                         vdc.regs[8] & 0x03, vdc.regs[9] & 0x1f, /* vdc.regs[10] & 0x7f, vdc.regs[11] & 0x1f,  */
@@ -359,13 +359,11 @@ void vdc_store(uint16_t addr, uint8_t value)
                     /* v1/2 VDC, incrementing HSS moves screen to the right */
                     vdc.xsmooth = (vdc.regs[25] & 0x0F);
                 }
-                vdc.raster.xsmooth = 0;
                 /* Hack to get the line redrawn because we are not actually using the xsmooth in raster
                 (so the xsmooth color is irrelevant, but changing it still forces a repaint of the line) */
-                vdc.raster.xsmooth_color++;
+                vdc.xsmooth_color++;
 #else
                 vdc.xsmooth = (vdc.regs[22] >> 4) - ((vdc.regs[25] & 0x10) ? 1 : 0);
-                vdc.raster.xsmooth = 0;
 #endif
             }
             if ((vdc.regs[25] & 0x10u) != (oldval & 0x10u)) {
@@ -411,7 +409,7 @@ void vdc_store(uint16_t addr, uint8_t value)
                      vdc.raster.xsmooth_color = vdc.regs[26] & 0x0F; */
                 /* Set the xsmooth area too for the 0-7pixel gap between border & foreground */
 
-                vdc.raster.border_color = (vdc.regs[26] & 0x0F);
+                vdc.border_color = (vdc.regs[26] & 0x0F);
             }
 #ifdef REG_DEBUG
             log_message(vdc.log, "Color register %x.", vdc.regs[26]);
@@ -421,7 +419,7 @@ void vdc_store(uint16_t addr, uint8_t value)
         case 27:                /* R27  Row/Adrs. Increment */
             /* We need to redraw the current line if this changes,
             as cache will be wrong. Uses xsmooth_color hack (see reg 25) */
-            vdc.raster.xsmooth_color++;
+            vdc.xsmooth_color++;
 #ifdef REG_DEBUG
             log_message(vdc.log, "Row/Adrs. Increment %i.", vdc.regs[27]);
 #endif
@@ -535,7 +533,7 @@ uint8_t vdc_read(uint16_t addr)
         }
 
         /* Emulate vblank bit.  */
-        if ((vdc.raster.current_line <= vdc.border_height) || (vdc.raster.current_line > (vdc.border_height + vdc.screen_ypix))) {
+        if ((vdc.current_line <= vdc.border_height) || (vdc.current_line > (vdc.border_height + vdc.screen_ypix))) {
             retval |= 0x20;
         }
 
@@ -573,7 +571,7 @@ uint8_t vdc_ram_read(uint16_t addr)
 
 void vdc_ram_store(uint16_t addr, uint8_t value)
 {
-    vdc.ram[addr & vdc.vdc_address_mask] = value;
+    vdc_ram_write(addr & vdc.vdc_address_mask, value);
 }
 
 
@@ -598,7 +596,7 @@ int vdc_dump(void *context, uint16_t addr)
     }
     mon_out("\nVDC Revision   : %d", vdc.revision);
     mon_out("\nVertical Blanking Period: ");
-    mon_out(((vdc.raster.current_line <= vdc.border_height) || (vdc.raster.current_line > (vdc.border_height + vdc.screen_ypix))) ? "Yes" : "No");
+    mon_out(((vdc.current_line <= vdc.border_height) || (vdc.current_line > (vdc.border_height + vdc.screen_ypix))) ? "Yes" : "No");
     mon_out("\nLight Pen Triggered: ");
     mon_out(vdc.light_pen.triggered ? "Yes" : "No");
     mon_out("\nStatus         : ");
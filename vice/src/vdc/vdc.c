@@ -54,8 +54,19 @@
 #include "video.h"
 #include "viewport.h"
 
+#ifdef HAVE_THREADS
+#include "rthreads/rthreads.h"
+#endif
+
+#ifdef __LIBRETRO__
+#include "retro_perf.h"
+#endif
+
 vdc_t vdc;
 
+static vdc_line_t vdc_line;
+vdc_line_t *vdc_draw = &vdc_line;
+
 static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data);
 
 /* return pixel aspect ratio for current video mode */
@@ -160,6 +171,290 @@ static void vdc_invalidate_cache(raster_t *raster, unsigned int screen_height)
     raster_new_cache(raster, screen_height);
 }
 
+/* ---------------------------------------------------------------------*/
+
+/* Take what drawing the current raster line reads from the VDC.  */
+static void vdc_line_snapshot(vdc_line_t *line)
+{
+    memcpy(line->regs, vdc.regs, sizeof(line->regs));
+    line->screen_adr = vdc.screen_adr;
+    line->attribute_adr = vdc.attribute_adr;
+    line->chargen_adr = vdc.chargen_adr;
+    line->mem_counter = vdc.mem_counter;
+    line->mem_counter_inc = vdc.mem_counter_inc;
+    line->bitmap_counter = vdc.bitmap_counter;
+    line->bytes_per_char = vdc.bytes_per_char;
+    line->screen_text_cols = vdc.screen_text_cols;
+    line->border_width = vdc.border_width;
+    line->xsmooth = vdc.xsmooth;
+    line->attribute_offset = vdc.attribute_offset;
+    line->frame_counter = vdc.frame_counter;
+    line->attribute_blink = vdc.attribute_blink;
+    line->crsrpos = vdc.crsrpos;
+
+    line->ycounter = vdc.ycounter;
+    line->video_mode = vdc.video_mode;
+    line->border_color = vdc.border_color;
+    line->xsmooth_color = vdc.xsmooth_color;
+}
+
+static void vdc_draw_line(vdc_line_t *line)
+{
+    raster_t *raster = &vdc.raster;
+
+    raster->ycounter = line->ycounter;
+    raster->video_mode = line->video_mode;
+    raster->border_color = line->border_color;
+    raster->xsmooth_color = line->xsmooth_color;
+
+    vdc_draw = line;
+    raster_line_emulate(raster);
+}
+
+#ifdef HAVE_THREADS
+/* With parallel rendering the lines are drawn on a worker thread, in the
+   order they are emulated, from snapshots queued by the emulation.  The
+   worker has its own copy of the video memory, brought up to date with the
+   writes logged before each line.  The emulation only waits for the worker
+   at the end of a VDC frame, which touches the canvas, and whenever
+   something else needs the raster, see vdc_finish_drawing().  */
+
+#define VDC_LINE_QUEUE_SIZE     512     /* more than a frame */
+#define VDC_RAM_WRITES_MAX      16384
+
+typedef struct vdc_ram_write_s {
+    uint16_t addr;
+    uint8_t value;
+} vdc_ram_write_t;
+
+typedef struct vdc_worker_s {
+    sthread_t *thread;
+    slock_t *lock;
+    scond_t *cond;
+    vdc_line_t lines[VDC_LINE_QUEUE_SIZE];
+    unsigned int head;          /* lines queued */
+    unsigned int tail;          /* lines drawn */
+    int quit;
+
+    /* Video memory writes not in `ram' yet.  */
+    vdc_ram_write_t ram_writes[VDC_RAM_WRITES_MAX];
+    unsigned int num_ram_writes;
+    unsigned int ram_writes_done;
+
+#ifdef __LIBRETRO__
+    /* Time spent drawing, added to the perf counter of the worker.  */
+    retro_perf_tick_t perf_ticks;
+    unsigned int perf_lines;
+#endif
+
+    uint8_t ram[0x10000];
+} vdc_worker_t;
+
+static vdc_worker_t vdc_worker;
+
+static int vdc_parallel_rendering = 0;
+
+static void vdc_worker_apply_ram_writes(unsigned int num)
+{
+    while (vdc_worker.ram_writes_done < num) {
+        vdc_ram_write_t *write = &vdc_worker.ram_writes[vdc_worker.ram_writes_done++];
+
+        vdc_worker.ram[write->addr] = write->value;
+    }
+}
+
+static void vdc_worker_thread(void *data)
+{
+    slock_lock(vdc_worker.lock);
+    for (;;) {
+        vdc_line_t *line;
+#ifdef __LIBRETRO__
+        retro_perf_tick_t start;
+#endif
+
+        while (vdc_worker.tail == vdc_worker.head && !vdc_worker.quit) {
+            scond_wait(vdc_worker.cond, vdc_worker.lock);
+        }
+        if (vdc_worker.quit) {
+            break;
+        }
+        slock_unlock(vdc_worker.lock);
+
+        line = &vdc_worker.lines[vdc_worker.tail % VDC_LINE_QUEUE_SIZE];
+        vdc_worker_apply_ram_writes(line->ram_writes);
+#ifdef __LIBRETRO__
+        start = retro_perf_active ? retro_perf_ticks() : 0;
+#endif
+        vdc_draw_line(line);
+#ifdef __LIBRETRO__
+        if (start) {
+            vdc_worker.perf_ticks += retro_perf_ticks() - start;
+            vdc_worker.perf_lines++;
+        }
+#endif
+
+        slock_lock(vdc_worker.lock);
+        vdc_worker.tail++;
+        scond_signal(vdc_worker.cond);
+    }
+    slock_unlock(vdc_worker.lock);
+}
+
+static void vdc_worker_post(void)
+{
+    vdc_line_t *line;
+
+    slock_lock(vdc_worker.lock);
+    while (vdc_worker.head - vdc_worker.tail == VDC_LINE_QUEUE_SIZE) {
+        scond_wait(vdc_worker.cond, vdc_worker.lock);
+    }
+    line = &vdc_worker.lines[vdc_worker.head % VDC_LINE_QUEUE_SIZE];
+    vdc_line_snapshot(line);
+    line->ram = vdc_worker.ram;
+    line->ram_writes = vdc_worker.num_ram_writes;
+    vdc_worker.head++;
+    scond_signal(vdc_worker.cond);
+    slock_unlock(vdc_worker.lock);
+}
+
+static void vdc_worker_stop(void)
+{
+    if (!vdc_worker.thread) {
+        return;
+    }
+    vdc_finish_drawing();
+
+    slock_lock(vdc_worker.lock);
+    vdc_worker.quit = 1;
+    scond_signal(vdc_worker.cond);
+    slock_unlock(vdc_worker.lock);
+    sthread_join(vdc_worker.thread);
+
+    scond_free(vdc_worker.cond);
+    slock_free(vdc_worker.lock);
+    vdc_worker.thread = NULL;
+    vdc_worker.lock = NULL;
+    vdc_worker.cond = NULL;
+    vdc.raster.threaded = 0;
+}
+
+static void vdc_worker_start(void)
+{
+    if (vdc_worker.thread) {
+        return;
+    }
+    memcpy(vdc_worker.ram, vdc.ram, sizeof(vdc_worker.ram));
+    vdc_worker.num_ram_writes = 0;
+    vdc_worker.ram_writes_done = 0;
+    vdc_worker.head = 0;
+    vdc_worker.tail = 0;
+    vdc_worker.quit = 0;
+    vdc.raster.threaded = 1;
+
+    vdc_worker.lock = slock_new();
+    vdc_worker.cond = scond_new();
+    if (!vdc_worker.lock || !vdc_worker.cond
+        || !(vdc_worker.thread = sthread_create(vdc_worker_thread, NULL))) {
+        log_error(vdc.log, "Cannot start the line drawing thread.");
+        if (vdc_worker.cond) {
+            scond_free(vdc_worker.cond);
+        }
+        if (vdc_worker.lock) {
+            slock_free(vdc_worker.lock);
+        }
+        vdc_worker.lock = NULL;
+        vdc_worker.cond = NULL;
+        vdc.raster.threaded = 0;
+    }
+}
+#endif
+
+/* Draw the current raster line, now or on the worker thread.  */
+static void vdc_emulate_line(void)
+{
+#ifdef HAVE_THREADS
+    if (vdc_worker.thread) {
+        vdc_worker_post();
+    } else
+#endif
+    {
+        vdc_line_snapshot(&vdc_line);
+        vdc_line.ram = vdc.ram;
+        vdc_draw_line(&vdc_line);
+    }
+
+    vdc.current_line++;
+    if (vdc.current_line == vdc.raster.geometry->screen_size.height) {
+        vdc.current_line = 0;
+        /* The frame is refreshed on the canvas, and the next one starts
+           with changes to the raster geometry and cache.  */
+        vdc_finish_drawing();
+    }
+}
+
+/* Wait until the lines emulated so far are drawn.  */
+void vdc_finish_drawing(void)
+{
+#ifdef HAVE_THREADS
+    if (!vdc_worker.thread) {
+        return;
+    }
+    slock_lock(vdc_worker.lock);
+    while (vdc_worker.tail != vdc_worker.head) {
+        scond_wait(vdc_worker.cond, vdc_worker.lock);
+    }
+    slock_unlock(vdc_worker.lock);
+
+    vdc_worker_apply_ram_writes(vdc_worker.num_ram_writes);
+    vdc_worker.num_ram_writes = 0;
+    vdc_worker.ram_writes_done = 0;
+
+#ifdef __LIBRETRO__
+    /* The worker is idle, its counts can be read now */
+    if (vdc_worker.perf_lines) {
+        retro_perf_add(RETRO_PERF_VDC_WORKER, vdc_worker.perf_ticks, vdc_worker.perf_lines);
+        vdc_worker.perf_ticks = 0;
+        vdc_worker.perf_lines = 0;
+    }
+#endif
+#endif
+}
+
+/* Store a byte in the video memory.  */
+void vdc_ram_write(unsigned int addr, uint8_t value)
+{
+    vdc.ram[addr] = value;
+#ifdef HAVE_THREADS
+    if (vdc_worker.thread) {
+        vdc_ram_write_t *write = &vdc_worker.ram_writes[vdc_worker.num_ram_writes++];
+
+        write->addr = (uint16_t)addr;
+        write->value = value;
+        if (vdc_worker.num_ram_writes == VDC_RAM_WRITES_MAX) {
+            vdc_finish_drawing();
+        }
+    }
+#endif
+}
+
+/* Draw the lines on a worker thread.  */
+void vdc_set_parallel_rendering(int enable)
+{
+#ifdef HAVE_THREADS
+    vdc_parallel_rendering = enable;
+    if (!vdc.initialized) {
+        return;
+    }
+    if (enable) {
+        vdc_worker_start();
+    } else {
+        vdc_worker_stop();
+    }
+#endif
+}
+
+/* ---------------------------------------------------------------------*/
+
 static int init_raster(void)
 {
     raster_t *raster;
@@ -190,6 +485,8 @@ static int init_raster(void)
     }
 
     raster->border_color = 0;
+    vdc.border_color = 0;
+    vdc.xsmooth_color = 0;
 
     /* FIXME: this seems to be the only way to disable cache on VDC.
        The GUI (at least on win32) doesn't let you do it */
@@ -221,6 +518,12 @@ raster_t *vdc_init(void)
 
     vdc.initialized = 1;
 
+#ifdef HAVE_THREADS
+    if (vdc_parallel_rendering) {
+        vdc_worker_start();
+    }
+#endif
+
     /*vdc_set_geometry();*/
     resources_touch("VDCDoubleSize");
 
@@ -314,8 +617,12 @@ static void vdc_update_geometry(void)
 void vdc_reset(void)
 {
     if (vdc.initialized) {
+        vdc_finish_drawing();
         raster_reset(&vdc.raster);
     }
+    vdc.current_line = 0;
+    vdc.ycounter = 0;
+    vdc.video_mode = 0;
 
     vdc.frame_counter = 0;
     vdc.screen_text_cols = VDC_SCREEN_MAX_TEXTCOLS;
@@ -346,6 +653,12 @@ void vdc_powerup(void)
         vdc.ram[i] = v;
         v ^= 0xff;
     }
+#ifdef HAVE_THREADS
+    if (vdc_worker.thread) {
+        vdc_finish_drawing();
+        memcpy(vdc_worker.ram, vdc.ram, sizeof(vdc_worker.ram));
+    }
+#endif
     memset(vdc.regs, 0, sizeof(vdc.regs));
     vdc.mem_counter = 0;
     vdc.mem_counter_inc = 0;
@@ -403,12 +716,12 @@ void vdc_update_memory_ptrs(unsigned int cycle)
 static void vdc_increment_memory_pointer(void)
 {
     vdc.mem_counter_inc = vdc.screen_text_cols;
-    if (vdc.raster.ycounter >= vdc.raster_ycounter_max) {
+    if (vdc.ycounter >= vdc.raster_ycounter_max) {
         vdc.mem_counter += vdc.mem_counter_inc + vdc.regs[27];
     }
 
-    vdc.raster.ycounter = (vdc.raster.ycounter + 1)
-                          % (vdc.raster_ycounter_max + 1);
+    vdc.ycounter = (vdc.ycounter + 1)
+                   % (vdc.raster_ycounter_max + 1);
 
     vdc.bitmap_counter += vdc.mem_counter_inc + vdc.regs[27];
 }
@@ -416,20 +729,20 @@ static void vdc_increment_memory_pointer(void)
 static void vdc_increment_memory_pointer_interlace_bitmap(void)
 {   /* This is identical to above (and should remain so), we just don't increment the bitmap pointer */
     vdc.mem_counter_inc = vdc.screen_text_cols;
-    if (vdc.raster.ycounter >= vdc.raster_ycounter_max) {
+    if (vdc.ycounter >= vdc.raster_ycounter_max) {
         vdc.mem_counter += vdc.mem_counter_inc + vdc.regs[27];
     }
-    vdc.raster.ycounter = (vdc.raster.ycounter + 1)
-                          % (vdc.raster_ycounter_max + 1);
+    vdc.ycounter = (vdc.ycounter + 1)
+                   % (vdc.raster_ycounter_max + 1);
 }
 
 static void vdc_set_video_mode(void)
 {
-    vdc.raster.video_mode = (vdc.regs[25] & 0x80)
-                            ? VDC_BITMAP_MODE : VDC_TEXT_MODE;
+    vdc.video_mode = (vdc.regs[25] & 0x80)
+                     ? VDC_BITMAP_MODE : VDC_TEXT_MODE;
 
-    if (vdc.raster.ycounter > (unsigned int)(vdc.regs[9] & 0x1f)) {
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+    if (vdc.ycounter > (unsigned int)(vdc.regs[9] & 0x1f)) {
+        vdc.video_mode = VDC_IDLE_MODE;
     }
 }
 
@@ -456,7 +769,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
     }
 
     /* VDC locks in the screen/attr start addresses after the last raster line of foreground */
-    if (vdc.raster.current_line == vdc.border_height + vdc.screen_ypix + 1) {
+    if (vdc.current_line == vdc.border_height + vdc.screen_ypix + 1) {
         vdc.screen_adr = ((vdc.regs[12] << 8) | vdc.regs[13])
                          & vdc.vdc_address_mask;
         vdc.attribute_adr = ((vdc.regs[20] << 8) | vdc.regs[21])
@@ -469,7 +782,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
         }
     }
 
-    if (vdc.raster.current_line == 0) { /* We are on the first raster line, so go reset and/or handle everything for a new frame */
+    if (vdc.current_line == 0) { /* We are on the first raster line, so go reset and/or handle everything for a new frame */
         /* The top border position is based on the position of the vertical
            sync pulse [7] in relation to the total height of the screen [4]
            and the width of the sync pulse [3] */
@@ -503,7 +816,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
         vdc.raster.display_ystop = vdc.border_height + vdc.screen_ypix;
         vdc.row_counter = 0;
         vdc.row_counter_y = vdc.raster_ycounter_max;
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        vdc.video_mode = VDC_IDLE_MODE;
         vdc.frame_counter++;    /* Note that as far as the frame counter is concerned, we are now on a new frame */
         if (vdc.regs[24] & 0x20) {
             vdc.attribute_blink = vdc.frame_counter & 16;
@@ -557,7 +870,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
             vdc.mem_counter = 0;
             need_increment_memory_pointer = 0;
             vdc.bitmap_counter = 0;
-            vdc.raster.ycounter = 0;
+            vdc.ycounter = 0;
         }
         
         /* If interlace mode we need to skip to the 2nd line on an odd frame so that we render the odd field vs the even */
@@ -603,18 +916,18 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
     }
 
     /* If in_idle_state then we are not drawing anything on the current raster line */
-    in_idle_state = (vdc.raster.current_line < vdc.border_height)
-                    || vdc.raster.current_line < screen_ystart
-                    || (vdc.raster.current_line >= (vdc.border_height + vdc.screen_ypix));
+    in_idle_state = (vdc.current_line < vdc.border_height)
+                    || vdc.current_line < screen_ystart
+                    || (vdc.current_line >= (vdc.border_height + vdc.screen_ypix));
 
     if (!in_idle_state) {
         vdc_set_video_mode();
     } else {
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        vdc.video_mode = VDC_IDLE_MODE;
     }
 
     /* actually draw the current raster line */
-    raster_line_emulate(&vdc.raster);
+    vdc_emulate_line();
 
     /* see if we still should be drawing things - if we haven't drawn more than regs[6] rows since the top border */
     if (!in_idle_state) {
@@ -625,15 +938,15 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
             vdc.row_counter++;
             /* check if we are at the end of the display */
             if (vdc.row_counter == vdc.regs[6]) {
-                /* vdc.last_displayed_line = vdc.raster.current_line; */
+                /* vdc.last_displayed_line = vdc.current_line; */
                 /* FIXME - this is really a hack to lock in the screen/attr addresses at the next raster alarm handler */
-                vdc.screen_ypix = vdc.raster.current_line - vdc.border_height;
+                vdc.screen_ypix = vdc.current_line - vdc.border_height;
             }
         }
     }
 
     /* update the memory pointers if we are past screen_ystart, which may be above or below the top border */
-    need_increment_memory_pointer = (vdc.raster.current_line > screen_ystart);
+    need_increment_memory_pointer = (vdc.current_line > screen_ystart);
 
     vdc_set_next_alarm(offset);
 }
@@ -653,6 +966,7 @@ void vdc_calculate_xsync(void)
 
 void vdc_set_canvas_refresh(int enable)
 {
+    vdc_finish_drawing();
     raster_set_canvas_refresh(&vdc.raster, enable);
 }
 
@@ -668,6 +982,7 @@ int vdc_read_snapshot_module(snapshot_t *s)
 
 void vdc_screenshot(screenshot_t *screenshot)
 {
+    vdc_finish_drawing();
     raster_screenshot(&vdc.raster, screenshot);
     screenshot->chipid = "VDC";
     screenshot->video_regs = vdc.regs;
@@ -681,10 +996,14 @@ void vdc_screenshot(screenshot_t *screenshot)
 
 void vdc_async_refresh(struct canvas_refresh_s *refresh)
 {
+    vdc_finish_drawing();
     raster_async_refresh(&vdc.raster, refresh);
 }
 
 void vdc_shutdown(void)
 {
+#ifdef HAVE_THREADS
+    vdc_worker_stop();
+#endif
     raster_shutdown(&vdc.raster);
 }
@@ -53,6 +53,8 @@ extern int vdc_write_snapshot_module(struct snapshot_s *s);
 extern int vdc_read_snapshot_module(struct snapshot_s *s);
 
 extern void vdc_set_canvas_refresh(int enable);
+extern void vdc_set_parallel_rendering(int enable);
+extern void vdc_finish_drawing(void);
 extern void vdc_shutdown(void);
 
 #endif
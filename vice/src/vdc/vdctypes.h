@@ -183,6 +183,15 @@ struct vdc_s {
     /* VDC raster.  */
     raster_t raster;
 
+    /* Raster line being emulated and the raster state it is drawn with.
+       They are handed to `raster' when the line is drawn, which can happen
+       later on another thread, see vdc_set_parallel_rendering().  */
+    unsigned int current_line;
+    unsigned int ycounter;
+    int video_mode;
+    unsigned int border_color;
+    int xsmooth_color;
+
     /* Video chip capabilities.  */
     struct video_chip_cap_s *video_chip_cap;
 
@@ -213,6 +222,43 @@ typedef struct vdc_s vdc_t;
 
 extern vdc_t vdc;
 
+/* What drawing a raster line reads, taken from `vdc' when the line is
+   emulated.  */
+struct vdc_line_s {
+    uint8_t regs[64];
+    unsigned int screen_adr;
+    unsigned int attribute_adr;
+    unsigned int chargen_adr;
+    unsigned int mem_counter;
+    unsigned int mem_counter_inc;
+    unsigned int bitmap_counter;
+    unsigned int bytes_per_char;
+    unsigned int screen_text_cols;
+    unsigned int border_width;
+    unsigned int xsmooth;
+    unsigned int attribute_offset;
+    int frame_counter;
+    int attribute_blink;
+    int crsrpos;
+
+    /* Raster state of the line.  */
+    unsigned int ycounter;
+    int video_mode;
+    unsigned int border_color;
+    int xsmooth_color;
+
+    /* Video memory as of the line.  */
+    uint8_t *ram;
+
+    /* Number of video memory writes the line comes after, see
+       vdc_ram_write().  */
+    unsigned int ram_writes;
+};
+typedef struct vdc_line_s vdc_line_t;
+
+/* Line being drawn.  */
+extern vdc_line_t *vdc_draw;
+
 /* Private function calls, used by the other VDC modules.  */
 extern int vdc_load_palette(const char *name);
 extern void vdc_fetch_matrix(int offs, int num);
@@ -220,5 +266,6 @@ extern void vdc_update_memory_ptrs(unsigned int cycle);
 extern void vdc_update_video_mode(unsigned int cycle);
 extern void vdc_set_set_canvas_refresh(int enable);
 extern void vdc_calculate_xsync(void);
+extern void vdc_ram_write(unsigned int addr, uint8_t value);
 
 #endif
@@ -666,6 +666,9 @@ int vdrive_iec_close(vdrive_t *vdrive, unsigned int secondary)
             log_error(vdrive_iec_log, "Fatal: unknown floppy-close-mode: %i.", p->mode);
     }
 
+    /* The image is cached, bring the file up to date with the closed file */
+    disk_image_flush(vdrive->image);
+
     return status;
 }
 
@@ -888,6 +891,7 @@ void vdrive_iec_flush(vdrive_t *vdrive, unsigned int secondary)
         /* If no command, do nothing - keep error code.  */
         vdrive_command_execute(vdrive, p->buffer, p->bufptr);
         p->bufptr = 0;
+        disk_image_flush(vdrive->image);
     }
 }
 
@@ -781,7 +781,7 @@ int finalexpansion_snapshot_write_module(snapshot_t *s)
         || (SMW_B(m, register_b) < 0)
         || (SMW_B(m, lock_bit) < 0)
         || (SMW_BA(m, cart_ram, CART_RAM_SIZE) < 0)
-        || (SMW_BA(m, flash_state.flash_data, CART_ROM_SIZE) < 0)) {
+        || (SMW_BA_GEN(m, flash_state.flash_data, CART_ROM_SIZE, flash_state.generation) < 0)) {
         snapshot_module_close(m);
         return -1;
     }
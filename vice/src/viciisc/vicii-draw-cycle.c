@@ -529,6 +529,39 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     update_sprite_xpos();
 }
 
+/*
+ * The sprite pipeline of a cycle in which no sprite can trigger or be
+ * drawn.  Only the register pipes of draw_sprites8() are kept going,
+ * in the same pixel order.
+ */
+static DRAW_INLINE void update_sprites8(unsigned int cycle_flags)
+{
+    int s = cycle_get_sprite_num(cycle_flags);
+
+    /* pixel 3 */
+    if (cycle_is_sprite_ptr_dma0(cycle_flags)) {
+        sprite_halt_bits |= 1 << s;
+    }
+    /* pixel 4, sprite_pending_bits stays 0 as no sprite is displayed */
+    update_sprite_data(cycle_flags);
+    /* pixel 6 */
+    if (!vicii.color_latency) {
+        update_sprite_mc_bits_8565();
+    }
+    sprite_pri_bits = vicii.regs[0x1b];
+    sprite_expx_bits = vicii.regs[0x1d];
+    /* pixel 7 */
+    if (vicii.color_latency) {
+        update_sprite_mc_bits_6569();
+    }
+    if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
+        sprite_halt_bits &= ~(1 << s);
+    }
+
+    /* pipe xpos */
+    update_sprite_xpos();
+}
+
 
 /**************************************************************************
  *
@@ -634,6 +667,19 @@ static DRAW_INLINE void draw_colors8(void)
         cregs[last_color_reg] = last_color_value;
     }
 
+    /* nothing of a skipped frame is shown, only keep the pixel pipeline
+       in the state the rendering below leaves it */
+    if (vicii.raster.skip_frame) {
+        memcpy(pixel_buffer, render_buffer, 8);
+        if (vicii.color_latency) {
+            pixel_buffer[0] = cregs[pixel_buffer[0]];
+        }
+        vicii.dbuf_offset += 8;
+
+        update_cregs();
+        return;
+    }
+
     /* render pixels */
     if (vicii.color_latency) {
         draw_colors_6569(offs, 0);
@@ -675,7 +721,17 @@ void vicii_draw_cycle(void)
 
     draw_graphics8(cycle_flags_pipe);
 
-    draw_sprites8(cycle_flags_pipe);
+    /*
+     * Lines without sprites only need the sprite register pipes.  A sprite
+     * can only show up once it is pending, which takes a display bit at
+     * the display check cycle.
+     */
+    if (sprite_active_bits || sprite_pending_bits
+        || (vicii.sprite_display_bits && cycle_is_check_spr_disp(cycle_flags_pipe))) {
+        draw_sprites8(cycle_flags_pipe);
+    } else {
+        update_sprites8(cycle_flags_pipe);
+    }
 
     draw_border8();
 
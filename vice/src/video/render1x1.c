@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include "render1x1.h"
+#include "rendersimd.h"
 #include "types.h"
 
 
@@ -91,9 +92,13 @@ void render_16_1x1_04(const video_render_color_tables_t *color_tab, const uint8_
     const uint8_t *tmpsrc;
     uint16_t *tmptrg;
     unsigned int x, y, wstart, wfast, wend;
+    render_simd_palette_t palette;
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 1);
+    if (render_simd != NULL) {
+        render_simd_palette(&palette, colortab);
+    }
     if (width < 8) {
         wstart = width;
         wfast = 0;
@@ -105,6 +110,12 @@ void render_16_1x1_04(const video_render_color_tables_t *color_tab, const uint8_
         wend = (width - wstart) & 0x07; /* do not forget the rest*/
     }
     for (y = 0; y < height; y++) {
+        if (render_simd != NULL
+            && render_simd->line_16(&palette, colortab, src, trg, width)) {
+            src += pitchs;
+            trg += pitcht;
+            continue;
+        }
         tmpsrc = src;
         tmptrg = (uint16_t *)trg;
         for (x = 0; x < wstart; x++) {
@@ -218,9 +229,13 @@ void render_32_1x1_04(const video_render_color_tables_t *color_tab, const uint8_
     const uint8_t *tmpsrc;
     uint32_t *tmptrg;
     unsigned int x, y, wstart, wfast, wend;
+    render_simd_palette_t palette;
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 2);
+    if (render_simd != NULL) {
+        render_simd_palette(&palette, colortab);
+    }
     if (width < 8) {
         wstart = width;
         wfast = 0;
@@ -232,6 +247,12 @@ void render_32_1x1_04(const video_render_color_tables_t *color_tab, const uint8_
         wend = (width - wstart) & 0x07; /* do not forget the rest*/
     }
     for (y = 0; y < height; y++) {
+        if (render_simd != NULL
+            && render_simd->line_32(&palette, colortab, src, trg, width)) {
+            src += pitchs;
+            trg += pitcht;
+            continue;
+        }
         tmpsrc = src;
         tmptrg = (uint32_t *)trg;
         for (x = 0; x < wstart; x++) {
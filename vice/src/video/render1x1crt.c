@@ -28,6 +28,7 @@
 #include "vice.h"
 
 #include "render1x1crt.h"
+#include "rendersimd.h"
 #include "types.h"
 #include "video-color.h"
 
@@ -271,6 +272,11 @@ render_16_1x1_crt(video_render_color_tables_t *color_tab,
                    const unsigned int xt, const unsigned int yt,
                    const unsigned int pitchs, const unsigned int pitcht)
 {
+    if (render_simd != NULL) {
+        render_simd_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+                            pitchs, pitcht, 16, 0, NULL);
+        return;
+    }
     render_generic_1x1_crt(color_tab, src, trg, width, height, xs, ys, xt, yt,
                             pitchs, pitcht,
                             4, store_pixel_2, 0);
@@ -284,6 +290,11 @@ render_24_1x1_crt(video_render_color_tables_t *color_tab,
                    const unsigned int xt, const unsigned int yt,
                    const unsigned int pitchs, const unsigned int pitcht)
 {
+    if (render_simd != NULL) {
+        render_simd_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+                            pitchs, pitcht, 24, 0, NULL);
+        return;
+    }
     render_generic_1x1_crt(color_tab, src, trg, width, height, xs, ys, xt, yt,
                             pitchs, pitcht,
                             6, store_pixel_3, 0);
@@ -297,6 +308,11 @@ render_32_1x1_crt(video_render_color_tables_t *color_tab,
                    const unsigned int xt, const unsigned int yt,
                    const unsigned int pitchs, const unsigned int pitcht)
 {
+    if (render_simd != NULL) {
+        render_simd_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+                            pitchs, pitcht, 32, 0, NULL);
+        return;
+    }
     render_generic_1x1_crt(color_tab, src, trg, width, height, xs, ys, xt, yt,
                             pitchs, pitcht,
                             8, store_pixel_4, 0);
@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include "render1x1pal.h"
+#include "rendersimd.h"
 #include "types.h"
 #include "video-color.h"
 
@@ -313,6 +314,11 @@ render_16_1x1_pal(video_render_color_tables_t *color_tab,
                   const unsigned int xt, const unsigned int yt,
                   const unsigned int pitchs, const unsigned int pitcht, video_render_config_t *config)
 {
+    if (render_simd != NULL) {
+        render_simd_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+                            pitchs, pitcht, 16, 1, config);
+        return;
+    }
     render_generic_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
                            pitchs, pitcht,
                            4, store_pixel_2, 0, config);
@@ -326,6 +332,11 @@ render_24_1x1_pal(video_render_color_tables_t *color_tab,
                   const unsigned int xt, const unsigned int yt,
                   const unsigned int pitchs, const unsigned int pitcht, video_render_config_t *config)
 {
+    if (render_simd != NULL) {
+        render_simd_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+                            pitchs, pitcht, 24, 1, config);
+        return;
+    }
     render_generic_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
                            pitchs, pitcht,
                            6, store_pixel_3, 0, config);
@@ -339,6 +350,11 @@ render_32_1x1_pal(video_render_color_tables_t *color_tab,
                   const unsigned int xt, const unsigned int yt,
                   const unsigned int pitchs, const unsigned int pitcht, video_render_config_t *config)
 {
+    if (render_simd != NULL) {
+        render_simd_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
+                            pitchs, pitcht, 32, 1, config);
+        return;
+    }
     render_generic_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
                            pitchs, pitcht,
                            8, store_pixel_4, 0, config);
@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include "render1x2.h"
+#include "rendersimd.h"
 #include "types.h"
 #include <string.h>
 
@@ -107,10 +108,14 @@ void render_16_1x2_04(const video_render_color_tables_t *color_tab, const uint8_
     unsigned int x, y, wstart, wfast, wend, yys;
     uint16_t color;
     int readable = config->readable;
+    render_simd_palette_t palette;
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 1);
     yys = (ys << 1) | (yt & 1);
+    if (render_simd != NULL) {
+        render_simd_palette(&palette, colortab);
+    }
     if (width < 8) {
         wstart = width;
         wfast = 0;
@@ -127,6 +132,9 @@ void render_16_1x2_04(const video_render_color_tables_t *color_tab, const uint8_
         if (!(y & 1) || doublescan) {
             if ((y & 1) && readable && y > yys) { /* copy previous line */
                 memcpy(trg, trg - pitcht, width << 1);
+            } else if (render_simd != NULL
+                       && render_simd->line_16(&palette, colortab, src, trg, width)) {
+                /* converted by the SIMD kernel */
             } else {
                 for (x = 0; x < wstart; x++) {
                     *tmptrg++ = (uint16_t)colortab[*tmpsrc++];
@@ -334,10 +342,14 @@ void render_32_1x2_04(const video_render_color_tables_t *color_tab, const uint8_
     unsigned int x, y, wstart, wfast, wend, yys;
     uint32_t color;
     int readable = config->readable;
+    render_simd_palette_t palette;
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 2);
     yys = (ys << 1) | (yt & 1);
+    if (render_simd != NULL) {
+        render_simd_palette(&palette, colortab);
+    }
     if (width < 8) {
         wstart = width;
         wfast = 0;
@@ -354,6 +366,9 @@ void render_32_1x2_04(const video_render_color_tables_t *color_tab, const uint8_
         if (!(y & 1) || doublescan) {
             if ((y & 1) && readable && y > yys) { /* copy previous line */
                 memcpy(trg, trg - pitcht, width << 2);
+            } else if (render_simd != NULL
+                       && render_simd->line_32(&palette, colortab, src, trg, width)) {
+                /* converted by the SIMD kernel */
             } else {
                 for (x = 0; x < wstart; x++) {
                     *tmptrg++ = colortab[*tmpsrc++];
@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include "render2x2.h"
+#include "rendersimd.h"
 #include "types.h"
 #include <string.h>
 
@@ -122,10 +123,14 @@ void render_16_2x2_04(const video_render_color_tables_t *color_tab,
     unsigned int x, y, wfirst, wstart, wfast, wend, wlast, yys;
     uint32_t color;
     int readable = config->readable;
+    render_simd_palette_t palette;
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 1);
     yys = (ys << 1) | (yt & 1);
+    if (render_simd != NULL) {
+        render_simd_palette(&palette, colortab);
+    }
     wfirst = xt & 1;
     width -= wfirst;
     wlast = width & 1;
@@ -146,6 +151,15 @@ void render_16_2x2_04(const video_render_color_tables_t *color_tab,
         if (!(y & 1) || doublescan) {
             if ((y & 1) && readable && y > yys) { /* copy previous line */
                 memcpy(trg, trg - pitcht, ((width << 1) + wfirst + wlast) << 1);
+            } else if (render_simd != NULL
+                       && render_simd->line_32(&palette, colortab, src + wfirst,
+                                               trg + (wfirst << 1), width)) {
+                if (wfirst) {
+                    *((uint16_t *)trg) = (uint16_t)colortab[src[0]];
+                }
+                if (wlast) {
+                    *((uint16_t *)(trg + (wfirst << 1)) + (width << 1)) = (uint16_t)colortab[src[wfirst + width]];
+                }
             } else {
                 if (wfirst) {
                     *((uint16_t *)tmptrg) = (uint16_t)colortab[*tmpsrc++];
@@ -301,10 +315,14 @@ void render_32_2x2_04(const video_render_color_tables_t *color_tab,
     unsigned int x, y, wfirst, wstart, wfast, wend, wlast, yys;
     register uint32_t color;
     int readable = config->readable;
+    render_simd_palette_t palette;
 
     src = src + pitchs * ys + xs;
     trg = trg + pitcht * yt + (xt << 2);
     yys = (ys << 1) | (yt & 1);
+    if (render_simd != NULL) {
+        render_simd_palette(&palette, colortab);
+    }
     wfirst = xt & 1;
     width -= wfirst;
     wlast = width & 1;
@@ -325,6 +343,15 @@ void render_32_2x2_04(const video_render_color_tables_t *color_tab,
         if (!(y & 1) || doublescan) {
             if ((y & 1) && readable && y > yys) { /* copy previous line */
                 memcpy(trg, trg - pitcht, ((width << 1) + wfirst + wlast) << 2);
+            } else if (render_simd != NULL
+                       && render_simd->line_32_2x(&palette, colortab, src + wfirst,
+                                                  trg + (wfirst << 2), width)) {
+                if (wfirst) {
+                    tmptrg[0] = colortab[src[0]];
+                }
+                if (wlast) {
+                    tmptrg[wfirst + (width << 1)] = colortab[src[wfirst + width]];
+                }
             } else {
                 if (wfirst) {
                     *tmptrg++ = colortab[*tmpsrc++];
@@ -0,0 +1,898 @@
+/*
+ * rendersimd.c - SIMD palette lookup kernels for the RGB renderers
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The kernels convert 16 (32 with AVX2) pixels at once by looking up each
+   byte of the physical colors with a byte shuffle, then interleaving the
+   bytes into pixels.  This only covers color indices 0-15, which is all
+   the VIC-II, VIC, VDC and CRTC use; lines with higher indices are left to
+   the renderer's own loop.  The PAL and CRT emulation looks up its chroma
+   and luma tables the same way, then filters and converts 4 (8 with AVX2)
+   pixels at once; other colors are looked up one by one.  The x86 kernels
+   are compiled for their instruction set with target attributes and picked
+   by CPUID at runtime, NEON is part of every aarch64 CPU.  */
+
+#include "vice.h"
+
+#include "rendersimd.h"
+#include "types.h"
+#include "video-color.h"
+
+#if !defined(WORDS_BIGENDIAN) && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define RENDER_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if !defined(WORDS_BIGENDIAN) && defined(__aarch64__) && defined(__ARM_NEON)
+#define RENDER_SIMD_ARM64
+#include <arm_neon.h>
+#endif
+
+/* The PAL and CRT renderers work through a line in parts of this many
+   pixels.  */
+#define YUV_CHUNK 64
+
+/* The filters read 3 more source pixels, the kernels look up whole vectors */
+#define YUV_CHUNK_SRC (YUV_CHUNK + 32)
+
+typedef struct render_simd_yuv_s {
+    const int32_t *table[4];    /* cbtable, crtable, ytablel and ytableh */
+    const render_simd_palette_t *palette;   /* their colors 0-15 */
+    int32_t cb[YUV_CHUNK_SRC];  /* the tables of the source pixels */
+    int32_t cr[YUV_CHUNK_SRC];
+    int32_t yl[YUV_CHUNK_SRC];
+    int32_t yh[YUV_CHUNK_SRC];
+    int32_t red[YUV_CHUNK];     /* gamma table indices of the pixels */
+    int32_t grn[YUV_CHUNK];
+    int32_t blu[YUV_CHUNK];
+} render_simd_yuv_t;
+
+const render_simd_t *render_simd = NULL;
+
+static int render_simd_initialized = 0;
+
+void render_simd_palette(render_simd_palette_t *palette,
+                         const uint32_t *colortab)
+{
+    unsigned int i, k;
+
+    /* Bytes in memory order, so interleaving them again gives the pixel */
+    for (i = 0; i < 16; i++) {
+        const uint8_t *color = (const uint8_t *)&colortab[i];
+
+        for (k = 0; k < 4; k++) {
+            palette->plane[k][i] = color[k];
+        }
+    }
+}
+
+#if defined(RENDER_SIMD_X86) || defined(RENDER_SIMD_ARM64)
+
+/* The last pixels of a line, less than one vector */
+static void line_16_c(const uint32_t *colortab, const uint8_t *src,
+                      uint16_t *trg, unsigned int width)
+{
+    unsigned int x;
+
+    for (x = 0; x < width; x++) {
+        trg[x] = (uint16_t)colortab[src[x]];
+    }
+}
+
+static void line_32_c(const uint32_t *colortab, const uint8_t *src,
+                      uint32_t *trg, unsigned int width)
+{
+    unsigned int x;
+
+    for (x = 0; x < width; x++) {
+        trg[x] = colortab[src[x]];
+    }
+}
+
+static void line_32_2x_c(const uint32_t *colortab, const uint8_t *src,
+                         uint32_t *trg, unsigned int width)
+{
+    unsigned int x;
+
+    for (x = 0; x < width; x++) {
+        trg[x * 2] = trg[x * 2 + 1] = colortab[src[x]];
+    }
+}
+
+/* Source pixels the kernels did not look up */
+static void yuv_lookup_c(render_simd_yuv_t *yuv, const uint8_t *src,
+                         unsigned int x, unsigned int width)
+{
+    for (; x < width; x++) {
+        yuv->cb[x] = yuv->table[0][src[x]];
+        yuv->cr[x] = yuv->table[1][src[x]];
+        yuv->yl[x] = yuv->table[2][src[x]];
+        yuv->yh[x] = yuv->table[3][src[x]];
+    }
+}
+
+/* Same as render_generic_1x1_pal() and yuv_to_rgb() */
+static void yuv_line_c(render_simd_yuv_t *yuv, int32_t *line_u, int32_t *line_v,
+                       int off_flip, unsigned int x, unsigned int width)
+{
+    int32_t l, u, v;
+
+    for (; x < width; x++) {
+        l = yuv->yl[x + 1] + yuv->yh[x + 2] + yuv->yl[x + 3];
+        u = yuv->cb[x] + yuv->cb[x + 1] + yuv->cb[x + 2] + yuv->cb[x + 3];
+        v = yuv->cr[x] + yuv->cr[x + 1] + yuv->cr[x + 2] + yuv->cr[x + 3];
+        if (line_u != NULL) {
+            int32_t unew = u, vnew = v;
+
+            u += line_u[x];
+            v += line_v[x];
+            line_u[x] = unew;
+            line_v[x] = vnew;
+        }
+        u *= off_flip;
+        v *= off_flip;
+        yuv->red[x] = 256 + ((l + v) >> 16);
+        yuv->blu[x] = 256 + ((l + u) >> 16);
+        yuv->grn[x] = 256 + ((l - ((50 * u + 130 * v) >> 8)) >> 16);
+    }
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef RENDER_SIMD_X86
+
+/* All color indices of the line below 16? */
+__attribute__((target("sse2")))
+static int line_in_palette_sse2(const uint8_t *src, unsigned int width)
+{
+    const __m128i limit = _mm_set1_epi8(15);
+    __m128i max = _mm_setzero_si128();
+    unsigned int x;
+
+    for (x = 0; x + 16 <= width; x += 16) {
+        max = _mm_max_epu8(max, _mm_loadu_si128((const __m128i *)(src + x)));
+    }
+    for (; x < width; x++) {
+        if (src[x] > 15) {
+            return 0;
+        }
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(max, limit), limit)) == 0xffff;
+}
+
+__attribute__((target("ssse3")))
+static int line_16_ssse3(const render_simd_palette_t *palette,
+                         const uint32_t *colortab,
+                         const uint8_t *src, uint8_t *trg,
+                         unsigned int width)
+{
+    const __m128i p0 = _mm_loadu_si128((const __m128i *)palette->plane[0]);
+    const __m128i p1 = _mm_loadu_si128((const __m128i *)palette->plane[1]);
+    uint16_t *tmptrg = (uint16_t *)trg;
+    unsigned int x;
+
+    if (!line_in_palette_sse2(src, width)) {
+        return 0;
+    }
+    for (x = 0; x + 16 <= width; x += 16) {
+        __m128i idx, b0, b1;
+
+        idx = _mm_loadu_si128((const __m128i *)(src + x));
+        b0 = _mm_shuffle_epi8(p0, idx);
+        b1 = _mm_shuffle_epi8(p1, idx);
+        _mm_storeu_si128((__m128i *)(tmptrg + x), _mm_unpacklo_epi8(b0, b1));
+        _mm_storeu_si128((__m128i *)(tmptrg + x + 8), _mm_unpackhi_epi8(b0, b1));
+    }
+    line_16_c(colortab, src + x, tmptrg + x, width - x);
+    return 1;
+}
+
+__attribute__((target("ssse3")))
+static inline void lookup_32_ssse3(const __m128i *p, __m128i idx, uint32_t *trg)
+{
+    __m128i b0, b1, b2, b3, lo01, hi01, lo23, hi23;
+
+    b0 = _mm_shuffle_epi8(p[0], idx);
+    b1 = _mm_shuffle_epi8(p[1], idx);
+    b2 = _mm_shuffle_epi8(p[2], idx);
+    b3 = _mm_shuffle_epi8(p[3], idx);
+    lo01 = _mm_unpacklo_epi8(b0, b1);
+    hi01 = _mm_unpackhi_epi8(b0, b1);
+    lo23 = _mm_unpacklo_epi8(b2, b3);
+    hi23 = _mm_unpackhi_epi8(b2, b3);
+    _mm_storeu_si128((__m128i *)(trg + 0), _mm_unpacklo_epi16(lo01, lo23));
+    _mm_storeu_si128((__m128i *)(trg + 4), _mm_unpackhi_epi16(lo01, lo23));
+    _mm_storeu_si128((__m128i *)(trg + 8), _mm_unpacklo_epi16(hi01, hi23));
+    _mm_storeu_si128((__m128i *)(trg + 12), _mm_unpackhi_epi16(hi01, hi23));
+}
+
+__attribute__((target("ssse3")))
+static int line_32_ssse3(const render_simd_palette_t *palette,
+                         const uint32_t *colortab,
+                         const uint8_t *src, uint8_t *trg,
+                         unsigned int width)
+{
+    __m128i p[4];
+    uint32_t *tmptrg = (uint32_t *)trg;
+    unsigned int x;
+
+    if (!line_in_palette_sse2(src, width)) {
+        return 0;
+    }
+    for (x = 0; x < 4; x++) {
+        p[x] = _mm_loadu_si128((const __m128i *)palette->plane[x]);
+    }
+    for (x = 0; x + 16 <= width; x += 16) {
+        lookup_32_ssse3(p, _mm_loadu_si128((const __m128i *)(src + x)), tmptrg + x);
+    }
+    line_32_c(colortab, src + x, tmptrg + x, width - x);
+    return 1;
+}
+
+__attribute__((target("ssse3")))
+static int line_32_2x_ssse3(const render_simd_palette_t *palette,
+                            const uint32_t *colortab,
+                            const uint8_t *src, uint8_t *trg,
+                            unsigned int width)
+{
+    __m128i p[4];
+    uint32_t *tmptrg = (uint32_t *)trg;
+    unsigned int x;
+
+    if (!line_in_palette_sse2(src, width)) {
+        return 0;
+    }
+    for (x = 0; x < 4; x++) {
+        p[x] = _mm_loadu_si128((const __m128i *)palette->plane[x]);
+    }
+    for (x = 0; x + 16 <= width; x += 16) {
+        __m128i idx = _mm_loadu_si128((const __m128i *)(src + x));
+
+        /* doubling the indices doubles the pixels */
+        lookup_32_ssse3(p, _mm_unpacklo_epi8(idx, idx), tmptrg + x * 2);
+        lookup_32_ssse3(p, _mm_unpackhi_epi8(idx, idx), tmptrg + x * 2 + 16);
+    }
+    line_32_2x_c(colortab, src + x, tmptrg + x * 2, width - x);
+    return 1;
+}
+
+/* SSE2 has no 32 bit multiply keeping the low half, combine two 64 bit
+   results instead */
+__attribute__((target("ssse3")))
+static inline __m128i mullo_epi32_ssse3(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+#define LOAD_SSE(p) _mm_loadu_si128((const __m128i *)(p))
+#define STORE_SSE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+
+__attribute__((target("ssse3")))
+static void yuv_line_ssse3(render_simd_yuv_t *yuv, const uint8_t *src,
+                           int32_t *line_u, int32_t *line_v,
+                           int off_flip, unsigned int width)
+{
+    const __m128i off = _mm_set1_epi32(off_flip);
+    const __m128i c256 = _mm_set1_epi32(256);
+    /* the even lines and the CRT renderer scale by a power of 2 */
+    const int shift = off_flip > 0 && (off_flip & (off_flip - 1)) == 0 ? __builtin_ctz(off_flip) : -1;
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    unsigned int x = 0, i;
+
+    if (line_in_palette_sse2(src, width + 3)) {
+        __m128i p[4][4];
+
+        for (i = 0; i < 16; i++) {
+            p[i >> 2][i & 3] = LOAD_SSE(yuv->palette[i >> 2].plane[i & 3]);
+        }
+        for (; x + 16 <= width + 3; x += 16) {
+            __m128i idx = LOAD_SSE(src + x);
+
+            lookup_32_ssse3(p[0], idx, (uint32_t *)yuv->cb + x);
+            lookup_32_ssse3(p[1], idx, (uint32_t *)yuv->cr + x);
+            lookup_32_ssse3(p[2], idx, (uint32_t *)yuv->yl + x);
+            lookup_32_ssse3(p[3], idx, (uint32_t *)yuv->yh + x);
+        }
+    }
+    yuv_lookup_c(yuv, src, x, width + 3);
+
+    for (x = 0; x + 4 <= width; x += 4) {
+        __m128i l, u, v, g;
+
+        l = _mm_add_epi32(_mm_add_epi32(LOAD_SSE(yuv->yl + x + 1), LOAD_SSE(yuv->yh + x + 2)),
+                          LOAD_SSE(yuv->yl + x + 3));
+        u = _mm_add_epi32(_mm_add_epi32(LOAD_SSE(yuv->cb + x), LOAD_SSE(yuv->cb + x + 1)),
+                          _mm_add_epi32(LOAD_SSE(yuv->cb + x + 2), LOAD_SSE(yuv->cb + x + 3)));
+        v = _mm_add_epi32(_mm_add_epi32(LOAD_SSE(yuv->cr + x), LOAD_SSE(yuv->cr + x + 1)),
+                          _mm_add_epi32(LOAD_SSE(yuv->cr + x + 2), LOAD_SSE(yuv->cr + x + 3)));
+        if (line_u != NULL) {
+            __m128i uold = LOAD_SSE(line_u + x);
+            __m128i vold = LOAD_SSE(line_v + x);
+
+            STORE_SSE(line_u + x, u);
+            STORE_SSE(line_v + x, v);
+            u = _mm_add_epi32(u, uold);
+            v = _mm_add_epi32(v, vold);
+        }
+        if (shift >= 0) {
+            u = _mm_sll_epi32(u, count);
+            v = _mm_sll_epi32(v, count);
+        } else {
+            u = mullo_epi32_ssse3(u, off);
+            v = mullo_epi32_ssse3(v, off);
+        }
+        /* 50 * u + 130 * v */
+        g = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(u, 5), _mm_slli_epi32(u, 4)),
+                          _mm_add_epi32(_mm_slli_epi32(v, 7), _mm_slli_epi32(_mm_add_epi32(u, v), 1)));
+        g = _mm_sub_epi32(l, _mm_srai_epi32(g, 8));
+        STORE_SSE(yuv->red + x, _mm_add_epi32(c256, _mm_srai_epi32(_mm_add_epi32(l, v), 16)));
+        STORE_SSE(yuv->blu + x, _mm_add_epi32(c256, _mm_srai_epi32(_mm_add_epi32(l, u), 16)));
+        STORE_SSE(yuv->grn + x, _mm_add_epi32(c256, _mm_srai_epi32(g, 16)));
+    }
+    yuv_line_c(yuv, line_u, line_v, off_flip, x, width);
+}
+
+static const render_simd_t render_simd_ssse3 = {
+    line_16_ssse3,
+    line_32_ssse3,
+    line_32_2x_ssse3,
+    yuv_line_ssse3
+};
+
+/* The AVX2 shuffles and unpacks work within each 128 bit lane, so the
+   palette is in both lanes and the results are put in order at the end. */
+
+__attribute__((target("avx2")))
+static inline __m256i load_plane_avx2(const uint8_t *plane)
+{
+    __m128i p = _mm_loadu_si128((const __m128i *)plane);
+
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(p), p, 1);
+}
+
+__attribute__((target("avx2")))
+static int line_16_avx2(const render_simd_palette_t *palette,
+                        const uint32_t *colortab,
+                        const uint8_t *src, uint8_t *trg,
+                        unsigned int width)
+{
+    const __m256i p0 = load_plane_avx2(palette->plane[0]);
+    const __m256i p1 = load_plane_avx2(palette->plane[1]);
+    uint16_t *tmptrg = (uint16_t *)trg;
+    unsigned int x;
+
+    if (!line_in_palette_sse2(src, width)) {
+        return 0;
+    }
+    for (x = 0; x + 32 <= width; x += 32) {
+        __m256i idx, b0, b1, lo, hi;
+
+        idx = _mm256_loadu_si256((const __m256i *)(src + x));
+        b0 = _mm256_shuffle_epi8(p0, idx);
+        b1 = _mm256_shuffle_epi8(p1, idx);
+        lo = _mm256_unpacklo_epi8(b0, b1);  /* 0-7, 16-23 */
+        hi = _mm256_unpackhi_epi8(b0, b1);  /* 8-15, 24-31 */
+        _mm256_storeu_si256((__m256i *)(tmptrg + x), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(tmptrg + x + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    line_16_c(colortab, src + x, tmptrg + x, width - x);
+    return 1;
+}
+
+__attribute__((target("avx2")))
+static inline void lookup_32_avx2(const __m256i *p, __m256i idx, uint32_t *trg)
+{
+    __m256i b0, b1, b2, b3, lo01, hi01, lo23, hi23, r0, r1, r2, r3;
+
+    b0 = _mm256_shuffle_epi8(p[0], idx);
+    b1 = _mm256_shuffle_epi8(p[1], idx);
+    b2 = _mm256_shuffle_epi8(p[2], idx);
+    b3 = _mm256_shuffle_epi8(p[3], idx);
+    lo01 = _mm256_unpacklo_epi8(b0, b1);
+    hi01 = _mm256_unpackhi_epi8(b0, b1);
+    lo23 = _mm256_unpacklo_epi8(b2, b3);
+    hi23 = _mm256_unpackhi_epi8(b2, b3);
+    r0 = _mm256_unpacklo_epi16(lo01, lo23);  /* 0-3, 16-19 */
+    r1 = _mm256_unpackhi_epi16(lo01, lo23);  /* 4-7, 20-23 */
+    r2 = _mm256_unpacklo_epi16(hi01, hi23);  /* 8-11, 24-27 */
+    r3 = _mm256_unpackhi_epi16(hi01, hi23);  /* 12-15, 28-31 */
+    _mm256_storeu_si256((__m256i *)(trg + 0), _mm256_permute2x128_si256(r0, r1, 0x20));
+    _mm256_storeu_si256((__m256i *)(trg + 8), _mm256_permute2x128_si256(r2, r3, 0x20));
+    _mm256_storeu_si256((__m256i *)(trg + 16), _mm256_permute2x128_si256(r0, r1, 0x31));
+    _mm256_storeu_si256((__m256i *)(trg + 24), _mm256_permute2x128_si256(r2, r3, 0x31));
+}
+
+__attribute__((target("avx2")))
+static int line_32_avx2(const render_simd_palette_t *palette,
+                        const uint32_t *colortab,
+                        const uint8_t *src, uint8_t *trg,
+                        unsigned int width)
+{
+    __m256i p[4];
+    uint32_t *tmptrg = (uint32_t *)trg;
+    unsigned int x;
+
+    if (!line_in_palette_sse2(src, width)) {
+        return 0;
+    }
+    for (x = 0; x < 4; x++) {
+        p[x] = load_plane_avx2(palette->plane[x]);
+    }
+    for (x = 0; x + 32 <= width; x += 32) {
+        lookup_32_avx2(p, _mm256_loadu_si256((const __m256i *)(src + x)), tmptrg + x);
+    }
+    line_32_c(colortab, src + x, tmptrg + x, width - x);
+    return 1;
+}
+
+__attribute__((target("avx2")))
+static int line_32_2x_avx2(const render_simd_palette_t *palette,
+                           const uint32_t *colortab,
+                           const uint8_t *src, uint8_t *trg,
+                           unsigned int width)
+{
+    __m256i p[4];
+    uint32_t *tmptrg = (uint32_t *)trg;
+    unsigned int x;
+
+    if (!line_in_palette_sse2(src, width)) {
+        return 0;
+    }
+    for (x = 0; x < 4; x++) {
+        p[x] = load_plane_avx2(palette->plane[x]);
+    }
+    for (x = 0; x + 32 <= width; x += 32) {
+        __m256i idx = _mm256_loadu_si256((const __m256i *)(src + x));
+
+        /* quadwords 0, 2, 1, 3 so the lane wise unpacks double 0-15 and
+           16-31 in order */
+        idx = _mm256_permute4x64_epi64(idx, 0xd8);
+        lookup_32_avx2(p, _mm256_unpacklo_epi8(idx, idx), tmptrg + x * 2);
+        lookup_32_avx2(p, _mm256_unpackhi_epi8(idx, idx), tmptrg + x * 2 + 32);
+    }
+    line_32_2x_c(colortab, src + x, tmptrg + x * 2, width - x);
+    return 1;
+}
+
+#define LOAD_AVX2(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE_AVX2(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+
+__attribute__((target("avx2")))
+static void yuv_line_avx2(render_simd_yuv_t *yuv, const uint8_t *src,
+                          int32_t *line_u, int32_t *line_v,
+                          int off_flip, unsigned int width)
+{
+    const __m256i off = _mm256_set1_epi32(off_flip);
+    const __m256i c256 = _mm256_set1_epi32(256);
+    unsigned int x = 0, i;
+
+    if (line_in_palette_sse2(src, width + 3)) {
+        __m256i p[4][4];
+
+        for (i = 0; i < 16; i++) {
+            p[i >> 2][i & 3] = load_plane_avx2(yuv->palette[i >> 2].plane[i & 3]);
+        }
+        for (; x + 32 <= width + 3; x += 32) {
+            __m256i idx = LOAD_AVX2(src + x);
+
+            lookup_32_avx2(p[0], idx, (uint32_t *)yuv->cb + x);
+            lookup_32_avx2(p[1], idx, (uint32_t *)yuv->cr + x);
+            lookup_32_avx2(p[2], idx, (uint32_t *)yuv->yl + x);
+            lookup_32_avx2(p[3], idx, (uint32_t *)yuv->yh + x);
+        }
+    }
+    yuv_lookup_c(yuv, src, x, width + 3);
+
+    for (x = 0; x + 8 <= width; x += 8) {
+        __m256i l, u, v, g;
+
+        l = _mm256_add_epi32(_mm256_add_epi32(LOAD_AVX2(yuv->yl + x + 1), LOAD_AVX2(yuv->yh + x + 2)),
+                             LOAD_AVX2(yuv->yl + x + 3));
+        u = _mm256_add_epi32(_mm256_add_epi32(LOAD_AVX2(yuv->cb + x), LOAD_AVX2(yuv->cb + x + 1)),
+                             _mm256_add_epi32(LOAD_AVX2(yuv->cb + x + 2), LOAD_AVX2(yuv->cb + x + 3)));
+        v = _mm256_add_epi32(_mm256_add_epi32(LOAD_AVX2(yuv->cr + x), LOAD_AVX2(yuv->cr + x + 1)),
+                             _mm256_add_epi32(LOAD_AVX2(yuv->cr + x + 2), LOAD_AVX2(yuv->cr + x + 3)));
+        if (line_u != NULL) {
+            __m256i uold = LOAD_AVX2(line_u + x);
+            __m256i vold = LOAD_AVX2(line_v + x);
+
+            STORE_AVX2(line_u + x, u);
+            STORE_AVX2(line_v + x, v);
+            u = _mm256_add_epi32(u, uold);
+            v = _mm256_add_epi32(v, vold);
+        }
+        u = _mm256_mullo_epi32(u, off);
+        v = _mm256_mullo_epi32(v, off);
+        g = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(u, 5), _mm256_slli_epi32(u, 4)),
+                             _mm256_add_epi32(_mm256_slli_epi32(v, 7), _mm256_slli_epi32(_mm256_add_epi32(u, v), 1)));
+        g = _mm256_sub_epi32(l, _mm256_srai_epi32(g, 8));
+        STORE_AVX2(yuv->red + x, _mm256_add_epi32(c256, _mm256_srai_epi32(_mm256_add_epi32(l, v), 16)));
+        STORE_AVX2(yuv->blu + x, _mm256_add_epi32(c256, _mm256_srai_epi32(_mm256_add_epi32(l, u), 16)));
+        STORE_AVX2(yuv->grn + x, _mm256_add_epi32(c256, _mm256_srai_epi32(g, 16)));
+    }
+    yuv_line_c(yuv, line_u, line_v, off_flip, x, width);
+}
+
+static const render_simd_t render_simd_avx2 = {
+    line_16_avx2,
+    line_32_avx2,
+    line_32_2x_avx2,
+    yuv_line_avx2
+};
+
+#endif /* RENDER_SIMD_X86 */
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef RENDER_SIMD_ARM64
+
+static int line_in_palette_neon(const uint8_t *src, unsigned int width)
+{
+    uint8x16_t max = vdupq_n_u8(0);
+    unsigned int x;
+
+    for (x = 0; x + 16 <= width; x += 16) {
+        max = vmaxq_u8(max, vld1q_u8(src + x));
+    }
+    for (; x < width; x++) {
+        if (src[x] > 15) {
+            return 0;
+        }
+    }
+    return vmaxvq_u8(max) <= 15;
+}
+
+static int line_16_neon(const render_simd_palette_t *palette,
+                        const uint32_t *colortab,
+                        const uint8_t *src, uint8_t *trg,
+                        unsigned int width)
+{
+    const uint8x16_t p0 = vld1q_u8(palette->plane[0]);
+    const uint8x16_t p1 = vld1q_u8(palette->plane[1]);
+    unsigned int x;
+
+    if (!line_in_palette_neon(src, width)) {
+        return 0;
+    }
+    for (x = 0; x + 16 <= width; x += 16) {
+        uint8x16_t idx = vld1q_u8(src + x);
+        uint8x16x2_t pixels;
+
+        pixels.val[0] = vqtbl1q_u8(p0, idx);
+        pixels.val[1] = vqtbl1q_u8(p1, idx);
+        vst2q_u8(trg + x * 2, pixels);
+    }
+    line_16_c(colortab, src + x, (uint16_t *)trg + x, width - x);
+    return 1;
+}
+
+static inline void lookup_32_neon(const uint8x16_t *p, uint8x16_t idx, uint8_t *trg)
+{
+    uint8x16x4_t pixels;
+
+    pixels.val[0] = vqtbl1q_u8(p[0], idx);
+    pixels.val[1] = vqtbl1q_u8(p[1], idx);
+    pixels.val[2] = vqtbl1q_u8(p[2], idx);
+    pixels.val[3] = vqtbl1q_u8(p[3], idx);
+    vst4q_u8(trg, pixels);
+}
+
+static int line_32_neon(const render_simd_palette_t *palette,
+                        const uint32_t *colortab,
+                        const uint8_t *src, uint8_t *trg,
+                        unsigned int width)
+{
+    uint8x16_t p[4];
+    unsigned int x;
+
+    if (!line_in_palette_neon(src, width)) {
+        return 0;
+    }
+    for (x = 0; x < 4; x++) {
+        p[x] = vld1q_u8(palette->plane[x]);
+    }
+    for (x = 0; x + 16 <= width; x += 16) {
+        lookup_32_neon(p, vld1q_u8(src + x), trg + x * 4);
+    }
+    line_32_c(colortab, src + x, (uint32_t *)trg + x, width - x);
+    return 1;
+}
+
+static int line_32_2x_neon(const render_simd_palette_t *palette,
+                           const uint32_t *colortab,
+                           const uint8_t *src, uint8_t *trg,
+                           unsigned int width)
+{
+    uint8x16_t p[4];
+    unsigned int x;
+
+    if (!line_in_palette_neon(src, width)) {
+        return 0;
+    }
+    for (x = 0; x < 4; x++) {
+        p[x] = vld1q_u8(palette->plane[x]);
+    }
+    for (x = 0; x + 16 <= width; x += 16) {
+        uint8x16_t idx = vld1q_u8(src + x);
+
+        lookup_32_neon(p, vzip1q_u8(idx, idx), trg + x * 8);
+        lookup_32_neon(p, vzip2q_u8(idx, idx), trg + x * 8 + 64);
+    }
+    line_32_2x_c(colortab, src + x, (uint32_t *)trg + x * 2, width - x);
+    return 1;
+}
+
+static void yuv_line_neon(render_simd_yuv_t *yuv, const uint8_t *src,
+                          int32_t *line_u, int32_t *line_v,
+                          int off_flip, unsigned int width)
+{
+    const int32x4_t c256 = vdupq_n_s32(256);
+    unsigned int x = 0, i;
+
+    if (line_in_palette_neon(src, width + 3)) {
+        uint8x16_t p[4][4];
+
+        for (i = 0; i < 16; i++) {
+            p[i >> 2][i & 3] = vld1q_u8(yuv->palette[i >> 2].plane[i & 3]);
+        }
+        for (; x + 16 <= width + 3; x += 16) {
+            uint8x16_t idx = vld1q_u8(src + x);
+
+            lookup_32_neon(p[0], idx, (uint8_t *)(yuv->cb + x));
+            lookup_32_neon(p[1], idx, (uint8_t *)(yuv->cr + x));
+            lookup_32_neon(p[2], idx, (uint8_t *)(yuv->yl + x));
+            lookup_32_neon(p[3], idx, (uint8_t *)(yuv->yh + x));
+        }
+    }
+    yuv_lookup_c(yuv, src, x, width + 3);
+
+    for (x = 0; x + 4 <= width; x += 4) {
+        int32x4_t l, u, v, g;
+
+        l = vaddq_s32(vaddq_s32(vld1q_s32(yuv->yl + x + 1), vld1q_s32(yuv->yh + x + 2)),
+                      vld1q_s32(yuv->yl + x + 3));
+        u = vaddq_s32(vaddq_s32(vld1q_s32(yuv->cb + x), vld1q_s32(yuv->cb + x + 1)),
+                      vaddq_s32(vld1q_s32(yuv->cb + x + 2), vld1q_s32(yuv->cb + x + 3)));
+        v = vaddq_s32(vaddq_s32(vld1q_s32(yuv->cr + x), vld1q_s32(yuv->cr + x + 1)),
+                      vaddq_s32(vld1q_s32(yuv->cr + x + 2), vld1q_s32(yuv->cr + x + 3)));
+        if (line_u != NULL) {
+            int32x4_t uold = vld1q_s32(line_u + x);
+            int32x4_t vold = vld1q_s32(line_v + x);
+
+            vst1q_s32(line_u + x, u);
+            vst1q_s32(line_v + x, v);
+            u = vaddq_s32(u, uold);
+            v = vaddq_s32(v, vold);
+        }
+        u = vmulq_n_s32(u, off_flip);
+        v = vmulq_n_s32(v, off_flip);
+        g = vsubq_s32(l, vshrq_n_s32(vmlaq_n_s32(vmulq_n_s32(u, 50), v, 130), 8));
+        vst1q_s32(yuv->red + x, vaddq_s32(c256, vshrq_n_s32(vaddq_s32(l, v), 16)));
+        vst1q_s32(yuv->blu + x, vaddq_s32(c256, vshrq_n_s32(vaddq_s32(l, u), 16)));
+        vst1q_s32(yuv->grn + x, vaddq_s32(c256, vshrq_n_s32(g, 16)));
+    }
+    yuv_line_c(yuv, line_u, line_v, off_flip, x, width);
+}
+
+static const render_simd_t render_simd_neon = {
+    line_16_neon,
+    line_32_neon,
+    line_32_2x_neon,
+    yuv_line_neon
+};
+
+#endif /* RENDER_SIMD_ARM64 */
+
+/* ------------------------------------------------------------------------- */
+
+static const render_simd_t *render_simd_kernels(int level)
+{
+    switch (level) {
+#ifdef RENDER_SIMD_X86
+        case RENDER_SIMD_SSSE3:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("ssse3") ? &render_simd_ssse3 : NULL;
+        case RENDER_SIMD_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &render_simd_avx2 : NULL;
+#endif
+#ifdef RENDER_SIMD_ARM64
+        case RENDER_SIMD_NEON:
+            return &render_simd_neon;
+#endif
+        default:
+            break;
+    }
+    return NULL;
+}
+
+/* Best kernels the CPU can run */
+int render_simd_detect(void)
+{
+    if (render_simd_kernels(RENDER_SIMD_AVX2) != NULL) {
+        return RENDER_SIMD_AVX2;
+    }
+    if (render_simd_kernels(RENDER_SIMD_SSSE3) != NULL) {
+        return RENDER_SIMD_SSSE3;
+    }
+    if (render_simd_kernels(RENDER_SIMD_NEON) != NULL) {
+        return RENDER_SIMD_NEON;
+    }
+    return RENDER_SIMD_NONE;
+}
+
+/* Returns -1 if the kernels are not available */
+int render_simd_select(int level)
+{
+    const render_simd_t *kernels = render_simd_kernels(level);
+
+    if (kernels == NULL && level != RENDER_SIMD_NONE) {
+        return -1;
+    }
+    render_simd = kernels;
+    render_simd_initialized = 1;
+    return 0;
+}
+
+void render_simd_init(void)
+{
+    if (!render_simd_initialized) {
+        render_simd_select(render_simd_detect());
+    }
+}
+
+const char *render_simd_name(int level)
+{
+    switch (level) {
+        case RENDER_SIMD_SSSE3:
+            return "ssse3";
+        case RENDER_SIMD_AVX2:
+            return "avx2";
+        case RENDER_SIMD_NEON:
+            return "neon";
+    }
+    return "c";
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* render_generic_1x1_pal() and render_generic_1x1_crt() for RGB targets,
+   with the filters and the conversion done by the kernels.  */
+void render_simd_1x1_pal(video_render_color_tables_t *color_tab,
+                         const uint8_t *src, uint8_t *trg,
+                         unsigned int width, const unsigned int height,
+                         unsigned int xs, const unsigned int ys,
+                         unsigned int xt, const unsigned int yt,
+                         const unsigned int pitchs, const unsigned int pitcht,
+                         int depth, int delayloop, video_render_config_t *config)
+{
+    /* cbtable, crtable, ytablel and ytableh, then the odd line ones */
+    const int32_t *tables[2][4] = {
+        { color_tab->cbtable, color_tab->crtable, color_tab->ytablel, color_tab->ytableh },
+        { color_tab->cbtable_odd, color_tab->crtable_odd, color_tab->ytablel, color_tab->ytableh }
+    };
+    render_simd_palette_t palettes[2][4];
+    const uint8_t *tmpsrc;
+    uint8_t *tmptrg;
+    int32_t *line_u = NULL, *line_v = NULL;
+    render_simd_yuv_t yuv;
+    unsigned int bytes = (unsigned int)depth >> 3;
+    unsigned int x, y, i, n, odd;
+    int off = 0, off_flip;
+
+    for (i = 0; i < 8; i++) {
+        render_simd_palette(&palettes[i >> 2][i & 3], (const uint32_t *)tables[i >> 2][i & 3]);
+    }
+
+    /* ensure starting on even coords */
+    if ((xt & 1) && xs > 0) {
+        xs--;
+        xt--;
+        width++;
+    }
+
+    src = src + pitchs * ys + xs - 2;
+    trg = trg + pitcht * yt + (xt >> 1) * 2 * bytes;
+
+    if (delayloop) {
+        /* prepare previous (delay-)line, u and v kept apart */
+        const int32_t *cbtable, *crtable;
+
+        line_u = color_tab->line_yuv_0;
+        line_v = line_u + VIDEO_MAX_OUTPUT_WIDTH;
+        tmpsrc = ys > 0 ? src - pitchs : src;
+
+        /* is the previous line odd or even? (inverted condition!) */
+        cbtable = (ys & 1) ? color_tab->cbtable : color_tab->cbtable_odd;
+        crtable = (ys & 1) ? color_tab->crtable : color_tab->crtable_odd;
+
+        for (x = 0; x < width; x++) {
+            line_u[x] = cbtable[tmpsrc[x]] + cbtable[tmpsrc[x + 1]]
+                        + cbtable[tmpsrc[x + 2]] + cbtable[tmpsrc[x + 3]];
+            line_v[x] = crtable[tmpsrc[x]] + crtable[tmpsrc[x + 1]]
+                        + crtable[tmpsrc[x + 2]] + crtable[tmpsrc[x + 3]];
+        }
+
+        /* Calculate odd line shading */
+        off = (int) (((float) config->video_resources.pal_oddlines_offset * (1.5f / 2000.0f) - (1.5f / 2.0f - 1.0f)) * (1 << 5));
+    }
+
+    /* pixels in pairs, as the C renderers */
+    width &= ~1U;
+
+    for (y = ys; y < height + ys; y++) {
+        if (!delayloop) {
+            off_flip = 1 << 6;
+            odd = 0;
+        } else if (y & 1) { /* odd sourceline */
+            off_flip = off;
+            odd = 1;
+        } else {
+            off_flip = 1 << 5;
+            odd = 0;
+        }
+        for (i = 0; i < 4; i++) {
+            yuv.table[i] = tables[odd][i];
+        }
+        yuv.palette = palettes[odd];
+
+        for (x = 0; x < width; x += n) {
+            n = width - x < YUV_CHUNK ? width - x : YUV_CHUNK;
+            tmptrg = trg + x * bytes;
+
+            render_simd->yuv_line(&yuv, src + x, line_u ? line_u + x : NULL,
+                                  line_v ? line_v + x : NULL, off_flip, n);
+
+            switch (depth) {
+                case 16:
+                    for (i = 0; i < n; i++) {
+                        ((uint16_t *)tmptrg)[i] = (uint16_t)(gamma_red[yuv.red[i]] | gamma_grn[yuv.grn[i]] | gamma_blu[yuv.blu[i]]);
+                    }
+                    break;
+                case 24:
+                    for (i = 0; i < n; i++) {
+                        uint32_t tmp = gamma_red[yuv.red[i]] | gamma_grn[yuv.grn[i]] | gamma_blu[yuv.blu[i]];
+
+                        tmptrg[i * 3] = (uint8_t)tmp;
+                        tmptrg[i * 3 + 1] = (uint8_t)(tmp >> 8);
+                        tmptrg[i * 3 + 2] = (uint8_t)(tmp >> 16);
+                    }
+                    break;
+                case 32:
+                    for (i = 0; i < n; i++) {
+                        ((uint32_t *)tmptrg)[i] = gamma_red[yuv.red[i]] | gamma_grn[yuv.grn[i]] | gamma_blu[yuv.blu[i]] | alpha;
+                    }
+                    break;
+            }
+        }
+
+        src += pitchs;
+        trg += pitcht;
+    }
+}
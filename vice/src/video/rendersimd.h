@@ -0,0 +1,83 @@
+/*
+ * rendersimd.h - SIMD palette lookup kernels for the RGB renderers
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RENDERSIMD_H
+#define VICE_RENDERSIMD_H
+
+#include "types.h"
+
+#include "video.h"
+
+#define RENDER_SIMD_NONE  0
+#define RENDER_SIMD_SSSE3 1
+#define RENDER_SIMD_AVX2  2
+#define RENDER_SIMD_NEON  3
+
+/* The first 16 physical colors split into one table per byte, as the byte
+   shuffle instructions look them up.  */
+typedef struct render_simd_palette_s {
+    uint8_t plane[4][16];
+} render_simd_palette_t;
+
+/* Converts a line, unless it uses colors above 15; returns 0 then */
+typedef int (*render_simd_line_t)(const render_simd_palette_t *palette,
+                                  const uint32_t *colortab,
+                                  const uint8_t *src, uint8_t *trg,
+                                  unsigned int width);
+
+struct render_simd_yuv_s;
+
+/* PAL and CRT emulation of part of a line: the chroma and luma filters,
+   the PAL delay line and the YUV to RGB conversion.  The delay line is
+   NULL for the CRT renderer.  */
+typedef void (*render_simd_yuv_line_t)(struct render_simd_yuv_s *yuv,
+                                       const uint8_t *src,
+                                       int32_t *line_u, int32_t *line_v,
+                                       int off_flip, unsigned int width);
+
+typedef struct render_simd_s {
+    render_simd_line_t line_16;     /* 16 bit pixels */
+    render_simd_line_t line_32;     /* 32 bit pixels, or doubled 16 bit ones */
+    render_simd_line_t line_32_2x;  /* doubled 32 bit pixels */
+    render_simd_yuv_line_t yuv_line;
+} render_simd_t;
+
+/* Kernels in use, NULL for the plain C renderers */
+extern const render_simd_t *render_simd;
+
+extern void render_simd_init(void);
+extern int render_simd_detect(void);
+extern int render_simd_select(int level);
+extern const char *render_simd_name(int level);
+extern void render_simd_palette(render_simd_palette_t *palette,
+                                const uint32_t *colortab);
+extern void render_simd_1x1_pal(video_render_color_tables_t *color_tab,
+                                const uint8_t *src, uint8_t *trg,
+                                unsigned int width, const unsigned int height,
+                                unsigned int xs, const unsigned int ys,
+                                unsigned int xt, const unsigned int yt,
+                                const unsigned int pitchs,
+                                const unsigned int pitcht, int depth,
+                                int delayloop, video_render_config_t *config);
+
+#endif
@@ -38,6 +38,7 @@
 #include "render2x2ntsc.h"
 #include "render2x2pal.h"
 #include "render2x4crt.h"
+#include "rendersimd.h"
 #include "renderyuv.h"
 #include "types.h"
 #include "video-render.h"
@@ -116,6 +117,9 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
 
     video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
 
+    /* picks the SIMD kernels of the RGB renderers on the first frame */
+    render_simd_init();
+
     rendermode = config->rendermode;
     colortab = &config->color_tables;
 
@@ -560,5 +560,10 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     log_debug("vsync: start:%lu  delay:%ld  sound-delay:%lf  end:%lu  next-frame:%lu  frame-ticks:%lu", 
                 now, delay, sound_delay * 1000000, vsyncarch_gettime(), next_frame_start, frame_ticks);
 #endif
+#ifdef __LIBRETRO__
+    /* The core decides which frames are skipped, see retro_skip_frame() */
+    skip_next_frame = 0;
+#endif
+
     return skip_next_frame;
 }
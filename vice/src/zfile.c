@@ -30,6 +30,11 @@
 
 /* This code might be improved a lot...  */
 
+/* fopencookie() */
+#if defined(__linux__) && !defined(__ANDROID__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "vice.h"
 
 #include <ctype.h>
@@ -68,6 +73,19 @@
 #define ZDEBUG(a)
 #endif
 
+/* Gzip files are uncompressed into memory where the C library can put a
+   stdio stream on top of a buffer, into a temporary file elsewhere.  */
+#ifdef HAVE_ZLIB
+#if defined(__linux__) && !defined(__ANDROID__)
+#define ZFILE_MEMORY
+#define ZFILE_MEMORY_FOPENCOOKIE
+#elif defined(__APPLE__) || defined(__ANDROID__) || defined(__FreeBSD__) \
+    || defined(__NetBSD__) || defined(__OpenBSD__)
+#define ZFILE_MEMORY
+#define ZFILE_MEMORY_FUNOPEN
+#endif
+#endif
+
 /* We could add more here...  */
 enum compression_type {
     COMPR_NONE,
@@ -76,13 +94,24 @@ enum compression_type {
     COMPR_ARCHIVE,
     COMPR_ZIPCODE,
     COMPR_LYNX,
-    COMPR_TZX
+    COMPR_TZX,
+    COMPR_MEMORY
 };
 
+/* Uncompressed contents of a file kept in memory.  */
+typedef struct zfile_memory_s {
+    char *data;
+    size_t size;                 /* Bytes of data.  */
+    size_t capacity;             /* Bytes allocated.  */
+    size_t pos;                  /* Stream position.  */
+    int dirty;                   /* Non-zero once the stream was written to.  */
+} zfile_memory_t;
+
 /* This defines a linked list of all the compressed files that have been
    opened.  */
 struct zfile_s {
     char *tmp_name;              /* Name of the temporary file.  */
+    zfile_memory_t *memory;      /* Contents, if not in a temporary file.  */
     char *orig_name;             /* Name of the original file.  */
     int write_mode;              /* Non-zero if the file is open for writing.*/
     FILE *stream;                /* Associated stdio-style stream.  */
@@ -96,6 +125,16 @@ typedef struct zfile_s zfile_t;
 
 static zfile_t *zfile_list = NULL;
 
+/* This defines a linked list of the files added with zfile_memory_add().  */
+struct zfile_memory_file_s {
+    char *name;                  /* Complete path of the file.  */
+    zfile_memory_t *memory;      /* Contents.  */
+    struct zfile_memory_file_s *next;
+};
+typedef struct zfile_memory_file_s zfile_memory_file_t;
+
+static zfile_memory_file_t *zfile_memory_files = NULL;
+
 static log_t zlog = LOG_ERR;
 
 /* ------------------------------------------------------------------------- */
@@ -125,6 +164,14 @@ static int file_is_gzip(const char *name)
 }
 
 
+static void zfile_memory_free(zfile_memory_t *memory)
+{
+    if (memory != NULL) {
+        lib_free(memory->data);
+        lib_free(memory);
+    }
+}
+
 static void zfile_list_destroy(void)
 {
     zfile_t *p;
@@ -134,6 +181,7 @@ static void zfile_list_destroy(void)
 
         lib_free(p->orig_name);
         lib_free(p->tmp_name);
+        zfile_memory_free(p->memory);
         next = p->next;
         lib_free(p);
         p = next;
@@ -142,6 +190,23 @@ static void zfile_list_destroy(void)
     zfile_list = NULL;
 }
 
+static void zfile_memory_files_destroy(void)
+{
+    zfile_memory_file_t *p;
+
+    for (p = zfile_memory_files; p != NULL; ) {
+        zfile_memory_file_t *next;
+
+        lib_free(p->name);
+        zfile_memory_free(p->memory);
+        next = p->next;
+        lib_free(p);
+        p = next;
+    }
+
+    zfile_memory_files = NULL;
+}
+
 static int zinit(void)
 {
     zlog = log_open("ZFile");
@@ -157,6 +222,7 @@ static int zinit(void)
 /* Add one zfile to the list.  `orig_name' is automatically expanded to the
    complete path.  */
 static void zfile_list_add(const char *tmp_name,
+                           zfile_memory_t *memory,
                            const char *orig_name,
                            enum compression_type type,
                            int write_mode,
@@ -169,6 +235,7 @@ static void zfile_list_add(const char *tmp_name,
 
     /* The new zfile becomes first on the list.  */
     new_zfile->tmp_name = tmp_name ? lib_stralloc(tmp_name) : NULL;
+    new_zfile->memory = memory;
     new_zfile->write_mode = write_mode;
     new_zfile->stream = stream;
     new_zfile->fd = fd;
@@ -186,8 +253,240 @@ static void zfile_list_add(const char *tmp_name,
 void zfile_shutdown(void)
 {
     zfile_list_destroy();
+    zfile_memory_files_destroy();
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* In-memory files.  */
+
+#ifdef ZFILE_MEMORY
+
+static size_t zfile_memory_read(zfile_memory_t *memory, char *buf, size_t size)
+{
+    if (memory->pos >= memory->size) {
+        return 0;
+    }
+    if (size > memory->size - memory->pos) {
+        size = memory->size - memory->pos;
+    }
+    memcpy(buf, memory->data + memory->pos, size);
+    memory->pos += size;
+    return size;
+}
+
+static size_t zfile_memory_write(zfile_memory_t *memory, const char *buf, size_t size)
+{
+    size_t end = memory->pos + size;
+
+    if (end > memory->capacity) {
+        memory->capacity = (end > memory->capacity * 2) ? end : memory->capacity * 2;
+        memory->data = lib_realloc(memory->data, memory->capacity);
+    }
+    /* Writing past the end leaves a hole of zeros like a file would */
+    if (memory->pos > memory->size) {
+        memset(memory->data + memory->size, 0, memory->pos - memory->size);
+    }
+    memcpy(memory->data + memory->pos, buf, size);
+    memory->pos = end;
+    if (end > memory->size) {
+        memory->size = end;
+    }
+    if (size > 0) {
+        memory->dirty = 1;
+    }
+    return size;
+}
+
+static long zfile_memory_seek(zfile_memory_t *memory, long offset, int whence)
+{
+    long base;
+
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = (long)memory->pos;
+            break;
+        case SEEK_END:
+            base = (long)memory->size;
+            break;
+        default:
+            return -1;
+    }
+    if (base + offset < 0) {
+        return -1;
+    }
+    memory->pos = (size_t)(base + offset);
+    return (long)memory->pos;
+}
+
+/* The memory is freed with the zfile, after it was written back */
+#ifdef ZFILE_MEMORY_FOPENCOOKIE
+static ssize_t zfile_cookie_read(void *cookie, char *buf, size_t size)
+{
+    return (ssize_t)zfile_memory_read(cookie, buf, size);
+}
+
+static ssize_t zfile_cookie_write(void *cookie, const char *buf, size_t size)
+{
+    return (ssize_t)zfile_memory_write(cookie, buf, size);
+}
+
+static int zfile_cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+    long pos = zfile_memory_seek(cookie, (long)*offset, whence);
+
+    if (pos < 0) {
+        return -1;
+    }
+    *offset = pos;
+    return 0;
+}
+
+static int zfile_cookie_close(void *cookie)
+{
+    return 0;
+}
+
+static FILE *zfile_memory_fopen(zfile_memory_t *memory, const char *mode)
+{
+    cookie_io_functions_t functions;
+
+    functions.read = zfile_cookie_read;
+    functions.write = zfile_cookie_write;
+    functions.seek = zfile_cookie_seek;
+    functions.close = zfile_cookie_close;
+
+    return fopencookie(memory, mode, functions);
+}
+#else
+static int zfile_cookie_read(void *cookie, char *buf, int size)
+{
+    return (int)zfile_memory_read(cookie, buf, (size_t)size);
+}
+
+static int zfile_cookie_write(void *cookie, const char *buf, int size)
+{
+    return (int)zfile_memory_write(cookie, buf, (size_t)size);
+}
+
+static fpos_t zfile_cookie_seek(void *cookie, fpos_t offset, int whence)
+{
+    return (fpos_t)zfile_memory_seek(cookie, (long)offset, whence);
+}
+
+static int zfile_cookie_close(void *cookie)
+{
+    return 0;
+}
+
+static FILE *zfile_memory_fopen(zfile_memory_t *memory, const char *mode)
+{
+    return funopen(memory, zfile_cookie_read, zfile_cookie_write,
+                   zfile_cookie_seek, zfile_cookie_close);
+}
+#endif
+
+/* Open a stream on `memory' like fopen() would on a file with its data.  */
+static FILE *zfile_memory_open(zfile_memory_t *memory, const char *mode)
+{
+    FILE *stream;
+
+    if (strchr(mode, 'w') != NULL) {
+        memory->size = 0;
+        memory->dirty = 1;
+    }
+    memory->pos = (strchr(mode, 'a') != NULL) ? memory->size : 0;
+
+    stream = zfile_memory_fopen(memory, mode);
+    if (stream != NULL && strchr(mode, 'a') != NULL) {
+        fseek(stream, 0, SEEK_END);
+    }
+    return stream;
+}
+
+static zfile_memory_file_t *zfile_memory_file_find(const char *name)
+{
+    zfile_memory_file_t *p;
+    char *fullname = NULL;
+
+    archdep_expand_path(&fullname, name);
+
+    for (p = zfile_memory_files; p != NULL; p = p->next) {
+        if (!strcmp(p->name, fullname)) {
+            break;
+        }
+    }
+
+    lib_free(fullname);
+    return p;
+}
+
+/* If `name' was added with zfile_memory_add(), return a copy of its
+   contents, so that every stream has a position of its own.  */
+static zfile_memory_t *try_open_memory_file(const char *name)
+{
+    zfile_memory_file_t *file;
+    zfile_memory_t *memory;
+
+    file = zfile_memory_file_find(name);
+    if (file == NULL) {
+        return NULL;
+    }
+
+    memory = lib_calloc(1, sizeof(zfile_memory_t));
+    memory->size = file->memory->size;
+    memory->capacity = (memory->size > 0) ? memory->size : 1;
+    memory->data = lib_malloc(memory->capacity);
+    memcpy(memory->data, file->memory->data, memory->size);
+    return memory;
 }
 
+/* If `name' has a gzip-like extension, uncompress it into memory.  */
+static zfile_memory_t *try_uncompress_with_gzip_memory(const char *name)
+{
+    zfile_memory_t *memory;
+    gzFile fdsrc;
+    int len;
+
+    if (!file_is_gzip(name)) {
+        return NULL;
+    }
+
+    fdsrc = gzopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        return NULL;
+    }
+
+    memory = lib_calloc(1, sizeof(zfile_memory_t));
+    memory->capacity = 0x10000;
+    memory->data = lib_malloc(memory->capacity);
+
+    do {
+        if (memory->size == memory->capacity) {
+            memory->capacity *= 2;
+            memory->data = lib_realloc(memory->data, memory->capacity);
+        }
+        len = gzread(fdsrc, memory->data + memory->size,
+                     (unsigned int)(memory->capacity - memory->size));
+        if (len > 0) {
+            memory->size += (size_t)len;
+        }
+    } while (len > 0);
+
+    gzclose(fdsrc);
+
+    if (len < 0) {
+        zfile_memory_free(memory);
+        return NULL;
+    }
+    return memory;
+}
+
+#endif /* ZFILE_MEMORY */
+
 /* ------------------------------------------------------------------------ */
 
 /* Uncompression.  */
@@ -763,10 +1062,13 @@ static const valid_archives_t valid_archives[] = {
    write mode.  */
 static enum compression_type try_uncompress(const char *name,
                                             char **tmp_name,
+                                            zfile_memory_t **memory,
                                             int write_mode)
 {
     int i;
 
+    *memory = NULL;
+
     for (i = 0; valid_archives[i].program; i++) {
         if ((*tmp_name = try_uncompress_archive(name, write_mode,
                                                 valid_archives[i].program,
@@ -780,6 +1082,12 @@ static enum compression_type try_uncompress(const char *name,
     }
 
     /* need this order or .tar.gz is misunderstood */
+#ifdef ZFILE_MEMORY
+    if ((*memory = try_uncompress_with_gzip_memory(name)) != NULL) {
+        *tmp_name = NULL;
+        return COMPR_GZIP;
+    }
+#endif
     if ((*tmp_name = try_uncompress_with_gzip(name)) != NULL) {
         return COMPR_GZIP;
     }
@@ -872,6 +1180,39 @@ static int compress_with_gzip(const char *src, const char *dest)
 #endif
 }
 
+#ifdef ZFILE_MEMORY
+/* Compress the contents of `memory' into `dest' using zlib.  */
+static int compress_memory_with_gzip(const zfile_memory_t *memory, const char *dest)
+{
+    gzFile fddest;
+    size_t pos, len;
+
+    fddest = gzopen(dest, MODE_WRITE "9");
+    if (fddest == NULL) {
+        return -1;
+    }
+
+    for (pos = 0; pos < memory->size; pos += len) {
+        len = memory->size - pos;
+        if (len > 0x10000) {
+            len = 0x10000;
+        }
+        if (gzwrite(fddest, memory->data + pos, (unsigned int)len) <= 0) {
+            gzclose(fddest);
+            return -1;
+        }
+    }
+
+    if (gzclose(fddest) != Z_OK) {
+        return -1;
+    }
+
+    ZDEBUG(("compress memory with zlib: OK."));
+
+    return 0;
+}
+#endif
+
 /* Compress `src' into `dest' using bzip.  */
 static int compress_with_bzip(const char *src, const char *dest)
 {
@@ -906,8 +1247,8 @@ static int compress_with_bzip(const char *src, const char *dest)
 }
 
 /* Compress `src' into `dest' using algorithm `type'.  */
-static int zfile_compress(const char *src, const char *dest,
-                          enum compression_type type)
+static int zfile_compress(const char *src, const zfile_memory_t *memory,
+                          const char *dest, enum compression_type type)
 {
     char *dest_backup_name;
     int retval;
@@ -970,6 +1311,12 @@ static int zfile_compress(const char *src, const char *dest,
 
     switch (type) {
         case COMPR_GZIP:
+#ifdef ZFILE_MEMORY
+            if (memory != NULL) {
+                retval = compress_memory_with_gzip(memory, dest);
+                break;
+            }
+#endif
             retval = compress_with_gzip(src, dest);
             break;
         case COMPR_BZIP:
@@ -1016,6 +1363,7 @@ static int zfile_compress(const char *src, const char *dest,
 FILE *zfile_fopen(const char *name, const char *mode)
 {
     char *tmp_name;
+    zfile_memory_t *memory;
     FILE *stream;
     enum compression_type type;
     int write_mode = 0;
@@ -1033,20 +1381,45 @@ FILE *zfile_fopen(const char *name, const char *mode)
         write_mode = 1;
     }
 
+#ifdef ZFILE_MEMORY
+    /* Files added with zfile_memory_add() are not on disk at all.  */
+    if ((memory = try_open_memory_file(name)) != NULL) {
+        stream = zfile_memory_open(memory, mode);
+        if (stream == NULL) {
+            zfile_memory_free(memory);
+            return NULL;
+        }
+        zfile_list_add(NULL, memory, name, COMPR_MEMORY, write_mode, stream, NULL);
+        return stream;
+    }
+#endif
+
     /* Check for write permissions.  */
     if (write_mode && ioutil_access(name, IOUTIL_ACCESS_W_OK) < 0) {
         return NULL;
     }
 
-    type = try_uncompress(name, &tmp_name, write_mode);
+    type = try_uncompress(name, &tmp_name, &memory, write_mode);
     if (type == COMPR_NONE) {
         stream = fopen(name, mode);
         if (stream == NULL) {
             return NULL;
         }
-        zfile_list_add(NULL, name, type, write_mode, stream, NULL);
+        zfile_list_add(NULL, NULL, name, type, write_mode, stream, NULL);
         return stream;
-    } else if (*tmp_name == '\0') {
+    }
+#ifdef ZFILE_MEMORY
+    if (memory != NULL) {
+        stream = zfile_memory_open(memory, mode);
+        if (stream == NULL) {
+            zfile_memory_free(memory);
+            return NULL;
+        }
+        zfile_list_add(NULL, memory, name, type, write_mode, stream, NULL);
+        return stream;
+    }
+#endif
+    if (*tmp_name == '\0') {
         errno = EACCES;
         return NULL;
     }
@@ -1057,7 +1430,7 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
-    zfile_list_add(tmp_name, name, type, write_mode, stream, NULL);
+    zfile_list_add(tmp_name, NULL, name, type, write_mode, stream, NULL);
 
     /* now we don't need the archdep_tmpnam allocation any more */
     lib_free(tmp_name);
@@ -1101,7 +1474,7 @@ static int handle_close(zfile_t *ptr)
         /* Recompress into the original file.  */
         if (ptr->orig_name
             && ptr->write_mode
-            && zfile_compress(ptr->tmp_name, ptr->orig_name, ptr->type)) {
+            && zfile_compress(ptr->tmp_name, NULL, ptr->orig_name, ptr->type)) {
             return -1;
         }
 
@@ -1111,6 +1484,31 @@ static int handle_close(zfile_t *ptr)
         }
     }
 
+#ifdef ZFILE_MEMORY
+    if (ptr->memory && ptr->type == COMPR_MEMORY) {
+        /* Keep what was written for the next open.  */
+        zfile_memory_file_t *file = zfile_memory_file_find(ptr->orig_name);
+
+        if (file != NULL && ptr->memory->dirty) {
+            zfile_memory_free(file->memory);
+            file->memory = ptr->memory;
+            ptr->memory = NULL;
+        }
+    }
+#endif
+
+    if (ptr->memory) {
+        /* Recompress into the original file, if it was written to.  */
+        if (ptr->type != COMPR_MEMORY
+            && ptr->orig_name
+            && ptr->write_mode
+            && ptr->memory->dirty
+            && zfile_compress(NULL, ptr->memory, ptr->orig_name, ptr->type)) {
+            return -1;
+        }
+        zfile_memory_free(ptr->memory);
+    }
+
     handle_close_action(ptr);
 
     /* Remove item from list.  */
@@ -1189,3 +1587,54 @@ int zfile_close_action(const char *filename, zfile_action_t action,
     lib_free(fullname);
     return -1;
 }
+
+/* Add a file `name' of `size' bytes that zfile_fopen() opens from memory
+   until the emulator shuts down, writes are kept there as well.  Returns the
+   contents to be filled in, or NULL if files cannot be kept in memory.  */
+char *zfile_memory_add(const char *name, size_t size)
+{
+#ifdef ZFILE_MEMORY
+    zfile_memory_file_t *file;
+
+    if (!zinit_done) {
+        zinit();
+    }
+
+    file = zfile_memory_file_find(name);
+    if (file == NULL) {
+        file = lib_malloc(sizeof(zfile_memory_file_t));
+        archdep_expand_path(&file->name, name);
+        file->next = zfile_memory_files;
+        zfile_memory_files = file;
+    } else {
+        zfile_memory_free(file->memory);
+    }
+
+    file->memory = lib_calloc(1, sizeof(zfile_memory_t));
+    file->memory->size = size;
+    file->memory->capacity = (size > 0) ? size : 1;
+    file->memory->data = lib_malloc(file->memory->capacity);
+    return file->memory->data;
+#else
+    return NULL;
+#endif
+}
+
+/* Remove a file added with zfile_memory_add().  */
+void zfile_memory_remove(const char *name)
+{
+#ifdef ZFILE_MEMORY
+    zfile_memory_file_t *file, **p;
+
+    file = zfile_memory_file_find(name);
+    for (p = &zfile_memory_files; *p != NULL; p = &(*p)->next) {
+        if (*p == file) {
+            *p = file->next;
+            lib_free(file->name);
+            zfile_memory_free(file->memory);
+            lib_free(file);
+            break;
+        }
+    }
+#endif
+}
@@ -39,6 +39,8 @@ typedef enum {
 
 extern FILE *zfile_fopen(const char *name, const char *mode);
 extern int zfile_fclose(FILE *stream);
+extern char *zfile_memory_add(const char *name, size_t size);
+extern void zfile_memory_remove(const char *name);
 
 extern void zfile_shutdown(void);
 